@@ -0,0 +1,77 @@
+/*
+ * Copyright (C) 2025 Eugene Hutorny <eugene@hutorny.in.ua>
+ *
+ * bench/arena.cxx - cost of allocating and deallocating arena pages
+ *
+ * Licensed under MIT License, see full text in LICENSE
+ * or visit page https://opensource.org/license/mit/
+ */
+
+#include <stubmmio/stubmmio.h>
+#include <stubmmio/bench.h>
+#include <mmio.h>
+#include <algorithm>
+
+namespace {
+using namespace stubmmio;
+using namespace stubmmio::detail;
+using namespace stubmmio::bench;
+
+constexpr std::uintptr_t base_address = 0x10000000;
+constexpr std::size_t pages = 100000;
+
+auto page_address(std::size_t index) {
+    return reinterpret_cast<void*>(base_address + index * page_size);
+}
+
+benchmark contiguous { "arena allocate range, per page", { 10, 100, 1000, 10000, 100000 }, [](std::size_t scale) {
+    const stub owner {};
+    return measure(std::max<std::size_t>(1, pages / scale), [&owner, scale](std::size_t) {
+        mmio::arena().allocate({page_address(0), page_address(scale)}, owner);
+        mmio::arena().deallocate(owner);
+    }) / static_cast<double>(scale);
+}};
+
+// separate pages are limited by the count of process mappings, vm.max_map_count
+benchmark separate { "arena allocate separate pages, per page", { 10, 100, 1000, 10000 }, [](std::size_t scale) {
+    const stub owner {};
+    return measure(std::max<std::size_t>(1, pages / 10 / scale), [&owner, scale](std::size_t) {
+        // a gap keeps pages from merging
+        for(std::size_t i = 0; i < scale; ++i) mmio::arena().allocate({page_address(i * 2), page_address(i * 2 + 1)}, owner);
+        mmio::arena().deallocate(owner);
+    }) / static_cast<double>(scale);
+}};
+
+/// allocates and fills a range with the policy, as set_page_fill does for large stubs
+double fill(std::size_t scale, const arena::policy_type& policy, page_fill_type type = page_fill_type::store) {
+    const stub owner {};
+    arena::policy(policy);
+    set_page_fill(0xFFFFFFFFFFFFFFFFULL, type);
+    const auto result = measure(std::max<std::size_t>(1, pages / 10 / scale), [&owner, scale](std::size_t) {
+        mmio::arena().allocate({page_address(0), page_address(scale)}, owner);
+        mmio::arena().deallocate(owner);
+    }) / static_cast<double>(scale);
+    set_page_nofill();
+    arena::policy({});
+    return result;
+}
+
+const benchmark::scales_type fill_scales { 256, 2048, 16384 };
+
+benchmark fill_faulting { "arena fill range, per page", fill_scales, [](std::size_t scale) {
+    return fill(scale, {});
+}};
+
+benchmark fill_populated { "arena fill populated range, per page", fill_scales, [](std::size_t scale) {
+    return fill(scale, { arena::prefault_type::populate, false, 0 });
+}};
+
+benchmark fill_hugepages { "arena fill huge paged range, per page", fill_scales, [](std::size_t scale) {
+    return fill(scale, { arena::prefault_type::populate_write, true, 0 });
+}};
+
+benchmark fill_mapped { "arena fill mapped range, per page", fill_scales, [](std::size_t scale) {
+    return fill(scale, {}, page_fill_type::mapped);
+}};
+
+} // namespace
@@ -0,0 +1,95 @@
+/*
+ * Copyright (C) 2025 Eugene Hutorny <eugene@hutorny.in.ua>
+ *
+ * bench/include/stubmmio/bench.h - minimal benchmark harness
+ *
+ * Licensed under MIT License, see full text in LICENSE
+ * or visit page https://opensource.org/license/mit/
+ */
+
+#pragma once
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <functional>
+#include <numeric>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace stubmmio::bench {
+using clock = std::chrono::steady_clock;
+
+/// prevents compiler from optimizing away computation of value
+template<typename Type>
+[[gnu::always_inline]] inline void keep(const Type& value) noexcept {
+    asm volatile("" : : "r,m"(value) : "memory");
+}
+
+/// runs operation given number of iterations and returns average time of one iteration in nanoseconds
+template<typename Operation>
+double measure(std::size_t iterations, Operation&& operation) {
+    const auto start = clock::now();
+    for(std::size_t i = 0; i < iterations; ++i) operation(i);
+    const std::chrono::duration<double, std::nano> elapsed = clock::now() - start;
+    return elapsed.count() / static_cast<double>(iterations);
+}
+
+/// time of one operation in nanoseconds, and percentiles of sampled times, if the operation was sampled
+struct result {
+    using percentile_type = std::pair<double, double>; ///< percent and time in nanoseconds
+    result(double ns) : nanoseconds { ns } {}
+    double nanoseconds;
+    std::vector<percentile_type> percentiles {};
+};
+
+/// returns mean time of sampled operations and percentiles of sampled times
+inline result distribution(std::vector<double> samples) {
+    if (samples.empty()) return 0.0;
+    std::ranges::sort(samples);
+    result value { std::accumulate(samples.begin(), samples.end(), 0.0) / static_cast<double>(samples.size()) };
+    for(const auto percent : std::array { 50.0, 90.0, 99.0, 99.9, 100.0 }) {
+        const auto rank = static_cast<std::size_t>(percent / 100.0 * static_cast<double>(samples.size() - 1) + 0.5);
+        value.percentiles.emplace_back(percent, samples[rank]);
+    }
+    return value;
+}
+
+/// runs operation given number of times and returns distribution of times, the operation returns its time in nanoseconds
+template<typename Operation>
+result sample(std::size_t samples, Operation&& operation) {
+    std::vector<double> times(samples);
+    for(std::size_t i = 0; i < samples; ++i) times[i] = operation(i);
+    return distribution(std::move(times));
+}
+
+/// benchmark measured at several scales, registered on construction
+class benchmark {
+public:
+    using scales_type = std::vector<std::size_t>;
+    using function_type = std::function<result(std::size_t scale)>;
+    benchmark(std::string_view name, scales_type scales, function_type function)
+      : name_ { name }, scales_ { std::move(scales) }, function_ { std::move(function) } {
+        registry().push_back(this);
+    }
+    benchmark(const benchmark&) = delete;
+    benchmark(benchmark&&) = delete;
+    benchmark& operator=(const benchmark&) = delete;
+    benchmark& operator=(benchmark&&) = delete;
+    ~benchmark() = default;
+    auto name() const noexcept { return name_; }
+    const auto& scales() const noexcept { return scales_; }
+    /// returns time of one operation in nanoseconds at given scale
+    result operator()(std::size_t scale) const { return function_(scale); }
+    static std::vector<const benchmark*>& registry() {
+        static std::vector<const benchmark*> instance {};
+        return instance;
+    }
+private:
+    std::string_view name_;
+    scales_type scales_;
+    function_type function_;
+};
+
+} // namespace stubmmio::bench
@@ -0,0 +1,65 @@
+/*
+ * Copyright (C) 2025 Eugene Hutorny <eugene@hutorny.in.ua>
+ *
+ * bench/main.cxx - main benchmark runner
+ *
+ * Licensed under MIT License, see full text in LICENSE
+ * or visit page https://opensource.org/license/mit/
+ */
+
+#include <stubmmio/stubmmio.h>
+#include <stubmmio/logger.h>
+#include <stubmmio/bench.h>
+#include <format>
+#include <iostream>
+#include <string_view>
+#include <utility>
+#include <unistd.h>
+
+namespace {
+using namespace stubmmio;
+
+void print_text(const bench::benchmark& bench, std::size_t scale, const bench::result& result) {
+    std::cout << std::format("{:<40} {:>8} {:>12.1f} ns", bench.name(), scale, result.nanoseconds);
+    for(const auto& [percent, time] : result.percentiles) std::cout << std::format("  p{} {:.0f}", percent, time);
+    std::cout << '\n';
+}
+
+void print_json(const bench::benchmark& bench, std::size_t scale, const bench::result& result, bool first) {
+    std::cout << std::format("{}\n    {{ \"name\": \"{}\", \"scale\": {}, \"ns\": {:.1f}",
+                             first ? "" : ",", bench.name(), scale, result.nanoseconds);
+    if (! result.percentiles.empty()) {
+        std::cout << ", \"percentiles\": {";
+        for(const char* separator = " "; const auto& [percent, time] : result.percentiles) {
+            std::cout << std::format("{}\"{}\": {:.1f}", separator, percent, time);
+            separator = ", ";
+        }
+        std::cout << " }";
+    }
+    std::cout << " }";
+}
+
+} // namespace
+
+/// usage: stubmmio-bench [--json] [name-prefix]
+int main(int argc, char *argv[]) {
+    logcategory::basic::level(priority::warning);
+    util::redirect logging(logovod::sink::clog);
+    arena::check_boundary();
+    arena::check_pagesize(getpagesize());
+    const bool json = argc > 1 && std::string_view { argv[1] } == "--json";
+    const int next = json ? 2 : 1;
+    const std::string_view filter { argc > next ? argv[next] : "" };
+    if (json) std::cout << std::format("{{\n  \"compiler\": \"{}\",\n  \"pagesize\": {},\n  \"benchmarks\": [", __VERSION__, getpagesize());
+    bool first = true;
+    for(const auto bench : bench::benchmark::registry()) {
+        if (! bench->name().starts_with(filter)) continue;
+        for(const auto scale : bench->scales()) {
+            const auto result = (*bench)(scale);
+            if (json) print_json(*bench, scale, result, std::exchange(first, false));
+            else print_text(*bench, scale, result);
+        }
+    }
+    if (json) std::cout << "\n  ]\n}\n";
+    return 0;
+}
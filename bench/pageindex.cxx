@@ -0,0 +1,84 @@
+/*
+ * Copyright (C) 2025 Eugene Hutorny <eugene@hutorny.in.ua>
+ *
+ * bench/pageindex.cxx - scaling of page lookups in the arena
+ *
+ * Licensed under MIT License, see full text in LICENSE
+ * or visit page https://opensource.org/license/mit/
+ */
+
+#include <stubmmio/stubmmio.h>
+#include <stubmmio/bench.h>
+#include <pageindex.h>
+#include <algorithm>
+#include <map>
+
+namespace {
+using namespace stubmmio;
+using namespace stubmmio::detail;
+using namespace stubmmio::bench;
+
+constexpr std::uintptr_t base_address = 0x10000000;
+constexpr std::size_t pages_per_entry = 3;
+constexpr std::size_t page_stride = pages_per_entry + 1; // a gap keeps entries from merging
+constexpr std::size_t lookups = 100000;
+const benchmark::scales_type scales { 10, 100, 1000, 10000 };
+
+struct entry {
+    pagerange range;
+};
+
+auto entry_address(std::size_t index, std::size_t page = 0) {
+    return reinterpret_cast<const void*>(base_address + (index * page_stride + page) * page_size);
+}
+
+pagerange entry_range(std::size_t index) {
+    return {entry_address(index), entry_address(index, pages_per_entry)};
+}
+
+/// a page in the middle of an entry, so that lookup by the first page misses
+pagerange inner_page(std::size_t index) {
+    return {entry_address(index, pages_per_entry / 2), entry_address(index, pages_per_entry / 2 + 1)};
+}
+
+/// reference implementation of the lookup, used by the arena before pageindex
+bool linear_contains(const std::map<pageid_type, entry>& entries, pagerange requested) {
+    if(entries.contains(requested.begin()))
+        return entries.at(requested.begin()).range.contains(requested);
+    auto found = std::find_if(entries.begin(), entries.end(), [requested](const auto& item) {
+        return requested.overlapping(item.second.range);
+    });
+    return found != entries.end() && found->second.range.contains(requested);
+}
+
+benchmark linear_lookup { "arena lookup linear (reference)", scales, [](std::size_t scale) {
+    std::map<pageid_type, entry> entries {};
+    for(std::size_t i = 0; i < scale; ++i) entries.emplace(entry_range(i).begin(), entry{entry_range(i)});
+    return measure(lookups, [&entries, scale](std::size_t i) {
+        keep(linear_contains(entries, inner_page(i % scale)));
+    });
+}};
+
+benchmark indexed_lookup { "arena lookup pageindex", scales, [](std::size_t scale) {
+    pageindex<entry> entries {};
+    for(std::size_t i = 0; i < scale; ++i) entries.insert(entry{entry_range(i)});
+    return measure(lookups, [&entries, scale](std::size_t i) {
+        keep(entries.covers(inner_page(i % scale)));
+    });
+}};
+
+benchmark verify_apply { "verify::apply per element", scales, [](std::size_t scale) {
+    stub setup {};
+    verify expected {};
+    for(std::size_t i = 0; i < scale; ++i) {
+        const auto addr = reinterpret_cast<region::address_type>(entry_address(i));
+        setup |= stub {{{addr, pages_per_entry * page_size}}};
+        expected |= verify {{address(addr + page_size * pages_per_entry / 2), std::uint32_t{}}};
+    }
+    setup();
+    return measure(std::max<std::size_t>(1, lookups / scale), [&expected](std::size_t) {
+        keep(expected());
+    }) / static_cast<double>(scale);
+}};
+
+} // namespace
@@ -0,0 +1,71 @@
+/*
+ * Copyright (C) 2025 Eugene Hutorny <eugene@hutorny.in.ua>
+ *
+ * bench/stimulus.cxx - latency from a write, meeting a stimulus condition, to its action
+ *
+ * Licensed under MIT License, see full text in LICENSE
+ * or visit page https://opensource.org/license/mit/
+ */
+
+#include <stubmmio/stubmmio.h>
+#include <stubmmio/stimulus.h>
+#include <stubmmio/bench.h>
+#include <pagerange.h>
+#include <list>
+#include <thread>
+
+namespace {
+using namespace stubmmio;
+using namespace stubmmio::detail;
+using namespace stubmmio::bench;
+using namespace std::chrono_literals;
+
+constexpr std::uintptr_t base_address = 0x10000000;
+constexpr std::size_t samples = 1000;
+using stimulus_type = stimulus<std::uint32_t, std::uint32_t, simple_condition<std::uint32_t>, simple_action<std::uint32_t>>;
+
+auto reg(std::uintptr_t offset) {
+    return reinterpret_cast<volatile std::uint32_t*>(base_address + offset);
+}
+
+/// stimulus under test watches the first register and sets the second one,
+/// stimuli in the background watch registers of the next page, never meeting their conditions
+result latency(istimulus::mode_type mode, std::size_t background) {
+    const stub setup {{{base_address, 2 * page_size}}};
+    setup();
+    const auto previous = istimulus::mode();
+    if (! istimulus::mode(mode)) return 0.0;
+    std::list<stimulus_type> others {};
+    for(std::size_t i = 0; i < background; ++i) {
+        others.emplace_back(address(base_address + page_size + i * sizeof(std::uint32_t)),
+                            [](volatile const std::uint32_t& value) noexcept { return value == 1U; },
+                            address(base_address + page_size - sizeof(std::uint32_t)),
+                            [](volatile std::uint32_t& value) noexcept { value = 1U; });
+    }
+    stimulus_type sut { inactive, address(base_address), [](volatile const std::uint32_t& value) noexcept { return value == 1U; },
+                        address(base_address + sizeof(std::uint32_t)), [](volatile std::uint32_t& value) noexcept { value = 1U; } };
+    auto measured = sample(samples, [&sut](std::size_t) {
+        *reg(0) = 0;
+        *reg(sizeof(std::uint32_t)) = 0;
+        sut();
+        const auto start = clock::now();
+        *reg(0) = 1;
+        const auto deadline = start + 1s;
+        // yielding lets the poller run if it shares the CPU with this thread
+        while(*reg(sizeof(std::uint32_t)) == 0 && clock::now() < deadline) std::this_thread::yield();
+        const std::chrono::duration<double, std::nano> elapsed = clock::now() - start;
+        return elapsed.count();
+    });
+    istimulus::mode(previous);
+    return measured;
+}
+
+benchmark poll { "stimulus latency poll, background", { 0, 16, 256 }, [](std::size_t scale) {
+    return latency(istimulus::mode_type::poll, scale);
+}};
+
+benchmark trap { "stimulus latency trap, background", { 0 }, [](std::size_t scale) {
+    return latency(istimulus::mode_type::trap, scale);
+}};
+
+} // namespace
@@ -0,0 +1,71 @@
+/*
+ * Copyright (C) 2025 Eugene Hutorny <eugene@hutorny.in.ua>
+ *
+ * bench/stub.cxx - cost of constructing, combining and applying stubs, and of verifying large spans
+ *
+ * Licensed under MIT License, see full text in LICENSE
+ * or visit page https://opensource.org/license/mit/
+ */
+
+#include <stubmmio/stubmmio.h>
+#include <stubmmio/bench.h>
+#include <pagerange.h>
+#include <algorithm>
+#include <span>
+
+namespace {
+using namespace stubmmio;
+using namespace stubmmio::detail;
+using namespace stubmmio::bench;
+
+constexpr std::uintptr_t base_address = 0x10000000;
+constexpr std::size_t elements = 100000;
+constexpr std::size_t stride = 64; // registers of a peripheral
+const benchmark::scales_type scales { 10, 100, 1000, 10000, 100000 };
+
+stub::elements_type registers(std::size_t count, std::size_t first = 0) {
+    stub::elements_type result {};
+    for(std::size_t i = first; i < first + count; ++i) {
+        const auto addr = base_address + i * stride;
+        result.try_emplace(result.end(), addr, address(addr), static_cast<std::uint32_t>(i));
+    }
+    return result;
+}
+
+auto iterations(std::size_t scale) {
+    return std::max<std::size_t>(1, elements / scale);
+}
+
+benchmark construct { "stub construct, per element", scales, [](std::size_t scale) {
+    return measure(iterations(scale), [scale](std::size_t) {
+        keep(stub{registers(scale)}.element_count());
+    }) / static_cast<double>(scale);
+}};
+
+benchmark combine { "stub operator|, per element", scales, [](std::size_t scale) {
+    const stub lhs { registers(scale / 2) };
+    const stub rhs { registers(scale - scale / 2, scale / 2) };
+    return measure(iterations(scale), [&lhs, &rhs](std::size_t) {
+        keep((lhs | rhs).element_count());
+    }) / static_cast<double>(scale);
+}};
+
+benchmark apply { "stub::apply, per element", scales, [](std::size_t scale) {
+    const stub setup { registers(scale) };
+    return measure(iterations(scale), [&setup](std::size_t) {
+        setup();
+    }) / static_cast<double>(scale);
+}};
+
+benchmark verify_span { "verify::apply span, per page", { 1, 16, 256, 4096 }, [](std::size_t scale) {
+    const std::span<volatile std::uint32_t> words { reinterpret_cast<volatile std::uint32_t*>(base_address),
+                                                    scale * page_size / sizeof(std::uint32_t) };
+    const stub setup {{ words, 0xA5A5A5A5U }};
+    setup();
+    const verify expected {{ words, 0xA5A5A5A5U }};
+    return measure(std::max<std::size_t>(1, 16384 / scale), [&expected](std::size_t) {
+        keep(expected());
+    }) / static_cast<double>(scale);
+}};
+
+} // namespace
@@ -0,0 +1,77 @@
+/*
+ * Copyright (C) 2025 Eugene Hutorny <eugene@hutorny.in.ua>
+ *
+ * bench/svd.cxx - cost of parsing an SVD file versus mapping its register table
+ *
+ * Licensed under MIT License, see full text in LICENSE
+ * or visit page https://opensource.org/license/mit/
+ */
+
+#include <stubmmio/svd.h>
+#include <stubmmio/bench.h>
+#include <filesystem>
+#include <format>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <unistd.h>
+
+namespace {
+using namespace stubmmio;
+using namespace stubmmio::bench;
+
+const benchmark::scales_type scales { 16, 128 };
+constexpr std::size_t registers_per_peripheral = 64;
+
+/// generates an SVD document of peripherals with registers of several fields each, about 4KB per register
+std::string generate(std::size_t peripherals) {
+    std::ostringstream text {};
+    text << "<?xml version=\"1.0\"?>\n<device><name>BENCH</name><size>32</size><peripherals>\n";
+    for(std::size_t p = 0; p < peripherals; ++p) {
+        text << std::format("<peripheral><name>P{}</name><baseAddress>0x{:X}</baseAddress><registers>\n", p, 0x40000000 + p * 0x1000);
+        for(std::size_t r = 0; r < registers_per_peripheral; ++r) {
+            text << std::format("<register><name>R{}</name><description>register {} of peripheral {}</description>"
+                                "<addressOffset>0x{:X}</addressOffset><resetValue>0x{:X}</resetValue><fields>\n", r, r, p, r * 4, r);
+            for(std::size_t f = 0; f < 8; ++f) {
+                text << std::format("<field><name>F{}</name><description>field {} &amp; more</description>"
+                                    "<bitOffset>{}</bitOffset><bitWidth>4</bitWidth><access>read-write</access></field>\n", f, f, f * 4);
+            }
+            text << "</fields></register>\n";
+        }
+        text << "</registers></peripheral>\n";
+    }
+    text << "</peripherals></device>\n";
+    return text.str();
+}
+
+benchmark parse { "svd parse, per peripheral", scales, [](std::size_t scale) {
+    const auto text = generate(scale);
+    return measure(1, [&](std::size_t) {
+        std::istringstream stream { text };
+        keep(svd::device::parse(stream).registers().size());
+    }) / static_cast<double>(scale);
+}};
+
+benchmark map { "svd map table, per peripheral", scales, [](std::size_t scale) {
+    const auto path = std::filesystem::temp_directory_path() / std::format("stubmmio-bench-{}.svdt", getpid());
+    {
+        std::istringstream stream { generate(scale) };
+        std::ofstream file { path, std::ios::binary };
+        svd::device::parse(stream).save(file);
+    }
+    const auto result = measure(16, [&](std::size_t) {
+        keep(svd::device::map(path).registers().size());
+    }) / static_cast<double>(scale);
+    std::filesystem::remove(path);
+    return result;
+}};
+
+benchmark reset { "svd on_reset stub, per register", scales, [](std::size_t scale) {
+    std::istringstream stream { generate(scale) };
+    const auto mcu = svd::device::parse(stream);
+    return measure(4, [&](std::size_t) {
+        keep(mcu.on_reset().element_count());
+    }) / static_cast<double>(scale * registers_per_peripheral);
+}};
+
+} // namespace
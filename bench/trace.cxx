@@ -0,0 +1,61 @@
+/*
+ * Copyright (C) 2025 Eugene Hutorny <eugene@hutorny.in.ua>
+ *
+ * bench/trace.cxx - cost of recording an access trace
+ *
+ * Licensed under MIT License, see full text in LICENSE
+ * or visit page https://opensource.org/license/mit/
+ */
+
+#include <stubmmio/stubmmio.h>
+#include <stubmmio/literals.h>
+#include <stubmmio/trace.h>
+#include <stubmmio/bench.h>
+
+namespace {
+using namespace stubmmio;
+using namespace stubmmio::bench;
+using namespace stubmmio::literals;
+
+constexpr std::uintptr_t base_address = 0x10000000;
+const benchmark::scales_type scales { 100000 };
+
+auto reg() {
+    return reinterpret_cast<volatile std::uint32_t*>(base_address);
+}
+
+benchmark accessor_disabled { "trace accessor, disabled", scales, [](std::size_t scale) {
+    stub setup {{address(base_address), 0_U32}};
+    setup();
+    return measure(scale, [](std::size_t i) {
+        trace::write(reg(), static_cast<std::uint32_t>(i));
+    });
+}};
+
+benchmark accessor_enabled { "trace accessor, recording", scales, [](std::size_t scale) {
+    stub setup {{address(base_address), 0_U32}};
+    setup();
+    trace::start(scale);
+    const auto result = measure(scale, [](std::size_t i) {
+        trace::write(reg(), static_cast<std::uint32_t>(i));
+    });
+    trace::stop();
+    keep(trace::collect().size());
+    return result;
+}};
+
+benchmark trapped { "trace trapped access", scales, [](std::size_t scale) {
+    stub setup {{address(base_address), 0_U32}};
+    setup();
+    trace::start(scale);
+    if (! trace::watch(region{ base_address, sizeof(std::uint32_t) })) return 0.0;
+    const auto result = measure(scale, [](std::size_t i) {
+        *reg() = static_cast<std::uint32_t>(i);
+    });
+    trace::unwatch(region{ base_address, sizeof(std::uint32_t) });
+    trace::stop();
+    keep(trace::collect().size());
+    return result;
+}};
+
+} // namespace
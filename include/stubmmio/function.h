@@ -0,0 +1,128 @@
+/*
+ * Copyright (C) 2025 Eugene Hutorny <eugene@hutorny.in.ua>
+ *
+ * function.h - copyable callable wrapper with inline storage
+ *
+ * Licensed under MIT License, see full text in LICENSE
+ * or visit page https://opensource.org/license/mit/
+ */
+
+#pragma once
+#include <cstddef>
+#include <functional>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace stubmmio::detail {
+
+template<typename Signature, std::size_t Capacity = 32>
+class small_function;
+
+/// small_function - copyable callable wrapper, which keeps callables up to Capacity bytes inline,
+/// larger callables are allocated on the heap
+template<typename Result, typename... Args, std::size_t Capacity>
+class small_function<Result(Args...), Capacity> {
+public:
+    /// true if Callable is kept inline, without allocation
+    template<typename Callable>
+    static constexpr bool fits = sizeof(Callable) <= Capacity && alignof(Callable) <= alignof(std::max_align_t)
+                              && std::is_nothrow_move_constructible_v<Callable>;
+
+    small_function() noexcept = default;
+    template<typename Callable>
+    requires (!std::is_same_v<std::remove_cvref_t<Callable>, small_function>
+              && std::is_invocable_r_v<Result, std::decay_t<Callable>&, Args...>)
+    small_function(Callable&& callable) : vtable_ { &vtable_for<std::decay_t<Callable>> } {
+        using type = std::decay_t<Callable>;
+        if constexpr (fits<type>)
+            new (storage_) type(std::forward<Callable>(callable));
+        else
+            new (storage_) type*(new type(std::forward<Callable>(callable)));
+    }
+    small_function(const small_function& that) : vtable_ { that.vtable_ } {
+        if (vtable_) vtable_->copy(that.storage_, storage_);
+    }
+    small_function(small_function&& that) noexcept : vtable_ { std::exchange(that.vtable_, nullptr) } {
+        if (vtable_) vtable_->move(that.storage_, storage_);
+    }
+    small_function& operator=(const small_function& that) {
+        if (this != &that) {
+            small_function copy { that };
+            *this = std::move(copy);
+        }
+        return *this;
+    }
+    small_function& operator=(small_function&& that) noexcept {
+        if (this != &that) {
+            reset();
+            vtable_ = std::exchange(that.vtable_, nullptr);
+            if (vtable_) vtable_->move(that.storage_, storage_);
+        }
+        return *this;
+    }
+    ~small_function() { reset(); }
+
+    Result operator()(Args... args) const {
+        if (! vtable_) throw std::bad_function_call{};
+        return vtable_->invoke(storage_, std::forward<Args>(args)...);
+    }
+    explicit operator bool() const noexcept { return vtable_ != nullptr; }
+    /// returns pointer to the callable if it is of Type, nullptr otherwise
+    template<typename Type>
+    const Type* target() const noexcept {
+        return vtable_ == &vtable_for<Type> ? &access<Type>(storage_) : nullptr;
+    }
+    /// returns true if the callable is kept inline
+    bool is_inline() const noexcept { return vtable_ != nullptr && vtable_->inlined; }
+private:
+    struct vtable {
+        Result (*invoke)(void*, Args...);
+        void (*copy)(const void* from, void* to);
+        void (*move)(void* from, void* to) noexcept;
+        void (*destroy)(void*) noexcept;
+        bool inlined;
+    };
+    template<typename Type>
+    static Type& access(void* storage) noexcept {
+        if constexpr (fits<Type>)
+            return *std::launder(static_cast<Type*>(storage));
+        else
+            return **std::launder(static_cast<Type**>(storage));
+    }
+    template<typename Type>
+    static constexpr vtable vtable_for {
+        [](void* storage, Args... args) -> Result {
+            return std::invoke(access<Type>(storage), std::forward<Args>(args)...);
+        },
+        [](const void* from, void* to) {
+            auto& source = access<Type>(const_cast<void*>(from));
+            if constexpr (fits<Type>)
+                new (to) Type(source);
+            else
+                new (to) Type*(new Type(source));
+        },
+        [](void* from, void* to) noexcept {
+            if constexpr (fits<Type>) {
+                new (to) Type(std::move(access<Type>(from)));
+                access<Type>(from).~Type();
+            } else {
+                new (to) Type*(&access<Type>(from));
+            }
+        },
+        [](void* storage) noexcept {
+            if constexpr (fits<Type>)
+                access<Type>(storage).~Type();
+            else
+                delete &access<Type>(storage);
+        },
+        fits<Type>
+    };
+    void reset() noexcept {
+        if (vtable_) std::exchange(vtable_, nullptr)->destroy(storage_);
+    }
+    const vtable* vtable_ {};
+    alignas(std::max_align_t) mutable std::byte storage_[Capacity] {};
+};
+
+} // namespace stubmmio::detail
@@ -50,6 +50,9 @@ struct sigsegv : configurable<sigsegv, basic> {};
 struct stimulus : configurable<stimulus, basic> {};
 struct mock : configurable<sigsegv, basic> {};
 struct verify : configurable<verify, basic> {};
+struct runner : configurable<runner, basic> {};
+struct trace : configurable<trace, basic> {};
+struct svd : configurable<svd, basic> {};
 
 template<typename ... Category>
 void reset() {
@@ -93,7 +96,8 @@ struct redirect : scoped_redirector<logcategory::basic> {
     using base::base;
     ~redirect() {
         logcategory::reset<logcategory::basic, logcategory::arena, logcategory::mock, logcategory::stimulus,
-                           logcategory::sigsegv, logcategory::verify>();
+                           logcategory::sigsegv, logcategory::verify, logcategory::runner,
+                           logcategory::trace, logcategory::svd>();
     }
 };
 
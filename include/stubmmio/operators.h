@@ -9,11 +9,14 @@
 
 #pragma once
 #include <algorithm>
+#include <array>
+#include <cstddef>
 #include <cstdint>
 #include <cstring>
 #include <source_location>
 #include <type_traits>
 #include <utility>
+#include <stubmmio/function.h>
 
 namespace stubmmio {
 
@@ -47,7 +50,7 @@ constexpr auto empty() noexcept { return [](void*, void*) noexcept {}; }
 
 struct generator {
     using siganture = void(void*, void*);
-    using operator_type = std::function<siganture>;
+    using operator_type = detail::small_function<siganture>;
 
     static auto none() noexcept { return [](void*, void*) noexcept {}; }
 
@@ -68,30 +71,73 @@ struct generator {
     }
 };
 static_assert(anoperator<generator>);
+static_assert(generator::operator_type::fits<decltype(generator::one(std::uint64_t{}))>);
+static_assert(generator::operator_type::fits<decltype(generator::all(std::uint64_t{}))>);
+
+namespace detail {
+/// comparison with a value or a fill pattern, kept as bytes so that verify may compile it in a plan
+struct pattern {
+    static constexpr std::size_t capacity = 16;
+    enum class kind_type : std::uint8_t { one, all };
+    template<typename Type>
+    requires (std::is_trivially_copyable_v<Type> && sizeof(Type) <= capacity)
+    pattern(const Type& value, kind_type kind_of, std::source_location loc) noexcept
+      : size { sizeof(Type) }, kind { kind_of }, location { loc } {
+        std::memcpy(bytes.data(), &value, sizeof(Type));
+    }
+    bool operator()(const void* b, const void* e) const {
+        if (kind == kind_type::one) {
+            ensure_size_match({b, e}, size, location);
+            return std::memcmp(b, bytes.data(), size) == 0;
+        }
+        ensure_size_multiplyof({b, e}, size, location);
+        const auto* end = static_cast<const std::byte*>(e);
+        for(auto i = static_cast<const std::byte*>(b); i + size <= end; i += size) {
+            if (std::memcmp(i, bytes.data(), size) != 0)
+                return false;
+        }
+        return true;
+    }
+    std::array<std::byte, capacity> bytes {};
+    std::uint8_t size;
+    kind_type kind;
+    std::source_location location;
+};
+} // namespace detail
 
 struct comparator {
     using siganture = bool(const void*, const void*);
-    using operator_type = std::function<siganture>;
+    using operator_type = detail::small_function<siganture>;
 
     static constexpr auto one(trivial_data auto v, std::source_location loc = std::source_location::current()) {
         using value_type = std::remove_cvref_t<decltype(v)>;
-        return [v = std::move(v), loc](const void* b, const void* e) -> bool {
-            detail::ensure_size_match({b, e}, sizeof(value_type), loc);
-            return std::memcmp(b, &v, sizeof(value_type)) == 0;
-        };
+        if constexpr (sizeof(value_type) <= detail::pattern::capacity) {
+            return detail::pattern { v, detail::pattern::kind_type::one, loc };
+        } else {
+            return [v = std::move(v), loc](const void* b, const void* e) -> bool {
+                detail::ensure_size_match({b, e}, sizeof(value_type), loc);
+                return std::memcmp(b, &v, sizeof(value_type)) == 0;
+            };
+        }
     }
 
     static constexpr auto all(/*trivial_data*/ auto v, std::source_location loc = std::source_location::current()) {
         using value_type = std::remove_cvref_t<decltype(v)>;
-        return [v = std::move(v), loc](const void* b, const void* e) {
-            detail::ensure_size_multiplyof({b, e}, sizeof(value_type), loc);
-            for(auto i = static_cast<const value_type*>(b); i != static_cast<const  value_type*>(e); ++i) {
-                if (std::memcmp(i, &v, sizeof(value_type)) != 0)
-                    return false;
-            }
-            return true;
-        };
+        if constexpr (std::is_trivially_copyable_v<value_type> && sizeof(value_type) <= detail::pattern::capacity) {
+            return detail::pattern { v, detail::pattern::kind_type::all, loc };
+        } else {
+            return [v = std::move(v), loc](const void* b, const void* e) {
+                detail::ensure_size_multiplyof({b, e}, sizeof(value_type), loc);
+                for(auto i = static_cast<const value_type*>(b); i != static_cast<const  value_type*>(e); ++i) {
+                    if (std::memcmp(i, &v, sizeof(value_type)) != 0)
+                        return false;
+                }
+                return true;
+            };
+        }
     }
 };
 static_assert(anoperator<comparator>);
+static_assert(comparator::operator_type::fits<decltype(comparator::one(std::uint64_t{}))>);
+static_assert(comparator::operator_type::fits<decltype(comparator::all(std::uint64_t{}))>);
 } // namespace stubmmio
@@ -0,0 +1,57 @@
+/*
+ * Copyright (C) 2025 Eugene Hutorny <eugene@hutorny.in.ua>
+ *
+ * runner.h - stubmmio parallel test runner
+ *
+ * Licensed under MIT License, see full text in LICENSE
+ * or visit page https://opensource.org/license/mit/
+ */
+
+#pragma once
+#include <cstdint>
+#include <functional>
+#include <source_location>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace stubmmio {
+
+/// runner - runs test cases in parallel in worker processes, forked from the current one.
+/// Workers inherit stubs, applied before the run, copy-on-write and take test cases from a shared queue.
+/// Results are aggregated in the current process.
+class runner {
+public:
+    /// test case function, returns true on success
+    using case_type = std::function<bool()>;
+    enum class status_type : std::uint8_t { pending, running, passed, failed, crashed };
+    struct result_type {
+        std::size_t passed {};
+        std::size_t failed {};
+        std::size_t crashed {};
+        std::vector<status_type> statuses {};
+        bool success() const noexcept { return failed == 0 && crashed == 0; }
+    };
+    /// constructs runner with given number of workers, zero stands for number of CPUs
+    explicit runner(unsigned workers = 0, std::source_location location = std::source_location::current());
+    /// adds a named test case
+    runner& add(std::string_view name, case_type function);
+    /// runs all test cases and waits for their completion
+    result_type run() const;
+    /// returns number of workers
+    auto workers() const noexcept { return workers_; }
+    /// returns number of test cases
+    auto case_count() const noexcept { return cases_.size(); }
+    /// returns source location of this runner
+    auto& location() const noexcept { return location_; }
+private:
+    struct test_case {
+        std::string name;
+        case_type function;
+    };
+    std::vector<test_case> cases_ {};
+    unsigned workers_;
+    std::source_location location_;
+};
+
+} // namespace stubmmio
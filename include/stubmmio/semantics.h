@@ -0,0 +1,89 @@
+/*
+ * Copyright (C) 2025 Eugene Hutorny <eugene@hutorny.in.ua>
+ *
+ * semantics.h - access semantics of stubbed registers
+ *
+ * Licensed under MIT License, see full text in LICENSE
+ * or visit page https://opensource.org/license/mit/
+ */
+
+#pragma once
+#include <concepts>
+#include <cstdint>
+#include <initializer_list>
+#include <source_location>
+#include <vector>
+#include <stubmmio/stubmmio.h>
+
+namespace stubmmio {
+
+/// semantics - access semantics of registers, such as write 1 to clear or clear on read bits,
+/// enforced by trapping accesses to their pages (x86-64 Linux only) while the semantics object exists.
+/// An access is taken as an access to the whole register, the width of the access is not known
+class semantics {
+public:
+    /// set, clear or toggle alias register - a write to it sets, clears or toggles written bits of the target register,
+    /// the alias register keeps its value
+    enum class alias_type : std::uint8_t { none, set, clear, toggle };
+    /// bit masks of a register
+    struct bits_type {
+        std::uint64_t read_only {};        ///< bits, which ignore writes
+        std::uint64_t write_1_to_clear {}; ///< bits, cleared by writing 1, writing 0 keeps them
+        std::uint64_t read_to_clear {};    ///< bits, cleared after a read
+    };
+    /// semantics of one register
+    struct rule {
+        std::uintptr_t address {};
+        std::uintptr_t target {};          ///< target register of an alias
+        bits_type bits {};
+        std::uint8_t size {};
+        alias_type alias {};
+    };
+    class element {
+    public:
+        /// register with semantics of its bits
+        template<std::unsigned_integral Type>
+        element(volatile Type* reg, bits_type bits, std::source_location location = std::source_location::current())
+          : rule_ { reinterpret_cast<std::uintptr_t>(reg), 0, bits, sizeof(Type), alias_type::none }, location_ { location } {}
+        /// alias of the target register
+        template<std::unsigned_integral Type>
+        element(volatile Type* alias, alias_type kind, volatile Type* target,
+                std::source_location location = std::source_location::current())
+          : rule_ { reinterpret_cast<std::uintptr_t>(alias), reinterpret_cast<std::uintptr_t>(target), {}, sizeof(Type), kind },
+            location_ { location } {}
+        /// 32 bit register at address with semantics of its bits
+        element(address reg, bits_type bits, std::source_location location = std::source_location::current())
+          : rule_ { static_cast<std::uintptr_t>(reg), 0, bits, sizeof(std::uint32_t), alias_type::none }, location_ { location } {}
+        /// 32 bit alias at address of the target register
+        element(address alias, alias_type kind, address target, std::source_location location = std::source_location::current())
+          : rule_ { static_cast<std::uintptr_t>(alias), static_cast<std::uintptr_t>(target), {}, sizeof(std::uint32_t), kind },
+            location_ { location } {}
+        auto& rule() const noexcept { return rule_; }
+        auto& location() const noexcept { return location_; }
+    private:
+        semantics::rule rule_;
+        std::source_location location_;
+    };
+    using initializer_list = std::initializer_list<element>;
+    /// attaches semantics to the registers of applied stubs, throws page_is_not_allocated if a register is not stubbed,
+    /// and duplicate_address if a register already has semantics
+    semantics(initializer_list elements, std::source_location location = std::source_location::current());
+    semantics(const semantics&) = delete;
+    semantics(semantics&&) = delete;
+    semantics& operator=(const semantics&) = delete;
+    semantics& operator=(semantics&&) = delete;
+    /// detaches semantics from the registers
+    ~semantics();
+    /// returns true if the semantics are enforced, false if traps are not supported
+    bool active() const noexcept { return active_; }
+    /// returns true if semantics can be enforced on this platform
+    static bool supported() noexcept;
+    auto& location() const noexcept { return location_; }
+    auto element_count() const noexcept { return elements_.size(); }
+private:
+    std::vector<element> elements_;
+    std::source_location location_;
+    bool active_ {};
+};
+
+} // namespace stubmmio
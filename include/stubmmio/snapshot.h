@@ -0,0 +1,54 @@
+/*
+ * Copyright (C) 2025 Eugene Hutorny <eugene@hutorny.in.ua>
+ *
+ * snapshot.h - stubmmio arena snapshot
+ *
+ * Licensed under MIT License, see full text in LICENSE
+ * or visit page https://opensource.org/license/mit/
+ */
+
+#pragma once
+#include <cstdint>
+#include <source_location>
+#include <vector>
+#include <stubmmio/stubmmio.h>
+
+namespace stubmmio {
+
+/// snapshot - captures state of all pages allocated in the MMIO arena
+/// Captured pages are backed by a memory file image and mapped copy-on-write,
+/// so that restore discards only the pages modified after the capture.
+/// While arena writes are tracked, restore visits only the pages written since the capture or the last restore
+class snapshot {
+public:
+    /// captures current state of the arena
+    explicit snapshot(std::source_location location = std::source_location::current());
+    snapshot(const snapshot&) = delete;
+    snapshot(snapshot&&) noexcept;
+    snapshot& operator=(const snapshot&) = delete;
+    snapshot& operator=(snapshot&&) noexcept;
+    ~snapshot();
+    /// restores the arena pages to the captured state
+    void operator()() const {
+        restore();
+    }
+    /// restores the arena pages to the captured state
+    void restore() const;
+    /// returns source location of this snapshot
+    auto& location() const noexcept { return location_; }
+    /// returns size of captured pages in bytes
+    std::size_t size_bytes() const noexcept;
+private:
+    struct captured {
+        std::uintptr_t address;
+        std::size_t size;
+        std::uint64_t serial;
+    };
+    std::vector<captured> ranges_ {};
+    int fd_ { -1 };
+    std::source_location location_;
+    /// arena tracking epoch, since which unwritten pages are equal to the image
+    mutable std::uint64_t epoch_ {};
+};
+
+} // namespace stubmmio
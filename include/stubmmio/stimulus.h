@@ -8,6 +8,9 @@
  */
 
 #pragma once
+#include <array>
+#include <atomic>
+#include <chrono>
 #include <type_traits>
 #include <concepts>
 #include <cstdint>
@@ -51,17 +54,100 @@ static inline constexpr struct inactive_type {} inactive {};
 class istimulus {
 public:
     enum class identity_type : std::uint64_t {};
-    enum class status_type { idle, active, running, done };
-    using spans_type = std::vector<detail::volatile_span>;
+    /// scheduled - the condition is met and the delayed action is pending
+    enum class status_type { idle, active, running, scheduled, done };
+    /// count of polls of a stimulator worker
+    enum class ticks : std::uint64_t {};
+    /// steady - delays are measured with the steady clock, simulated - with the clock advanced by advance()
+    enum class clock_type { steady, simulated };
+    /// poll - stimuli are polled by a background thread,
+    /// trap - watched pages are write protected and stimuli run on the thread, writing to them
+    /// userfault - watched pages are write protected with userfaultfd and stimuli run on a handler thread
+    enum class mode_type { poll, trap, userfault };
+    /// limits of polling backoff, applied while polled stimuli are not satisfied:
+    /// spins rounds with a pause, then yields rounds with a yield, then sleeps growing up to sleep
+    struct backoff_type {
+        unsigned spins;
+        unsigned yields;
+        std::chrono::microseconds sleep;
+    };
+    /// pool of polling workers, optionally pinned to CPUs, one per worker
+    struct pool_type {
+        unsigned workers;
+        std::vector<int> cpus;
+    };
+    /// group of a stimulus, which shard is selected by its watched page
+    static constexpr unsigned no_group = std::numeric_limits<unsigned>::max();
+    /// watched and modified spans
+    using spans_type = std::array<detail::volatile_span, 2>;
+    /// statistics of stimuli, accumulated since the first activation or the last reset
+    struct stats_type {
+        /// count of actions by latency from the condition found met to the action completed,
+        /// bucket i counts latencies in [2^i, 2^(i+1)) nanoseconds, the last one counts all longer ones
+        using histogram_type = std::array<std::uint64_t, 32>;
+        std::chrono::nanoseconds elapsed;   ///< time of accumulation
+        std::uint64_t polls;                ///< polls of stimuli by polling workers
+        std::uint64_t evaluations;          ///< evaluations of conditions, polled or run on trapped writes
+        std::uint64_t actions;              ///< completed actions
+        std::uint64_t removed;              ///< stimuli removed because their pages were deallocated
+        std::chrono::nanoseconds requests;  ///< time polling workers spent applying (de)activation requests
+        histogram_type latency;
+        /// returns polls per second
+        double poll_rate() const noexcept;
+        /// returns upper bound of the latency bucket, not exceeded by the percent of actions
+        std::chrono::nanoseconds percentile(double percent) const noexcept;
+    };
     virtual ~istimulus() = default;
     /// Activate or reactivate the stimulus
     void operator()() { activate(*this); }
     /// Returns stimulus status
-    auto status() const noexcept { return status_; }
+    auto status() const noexcept {
+        // status may change in a trap handler, run on a write by this thread
+        std::atomic_signal_fence(std::memory_order_seq_cst);
+        return status_;
+    }
     /// Returns count of active stimuli
     static std::size_t count();
     /// Terminates all stimuli
     static void terminate();
+    /// Sets mode for stimuli activated afterwards, returns false if the mode is not supported
+    static bool mode(mode_type);
+    /// Returns mode for stimuli being activated
+    static mode_type mode() noexcept;
+    /// Sets polling backoff limits
+    static void backoff(const backoff_type&) noexcept;
+    /// Returns polling backoff limits
+    static backoff_type backoff() noexcept;
+    /// Sets pool of polling workers, returns false if any polled stimulus is active.
+    /// Stimuli of one group or, if not grouped, watching one page are polled by one worker.
+    /// An action, activating or deactivating a stimulus of a worker, which waits for the action's one, throws stimulus_deadlock
+    static bool pool(const pool_type&);
+    /// Returns pool of polling workers
+    static pool_type pool();
+    /// Sets group of the stimulus, an active stimulus is reactivated
+    void group(unsigned);
+    /// Returns group of the stimulus
+    unsigned group() const noexcept { return group_; }
+    /// Delays the action by the duration after the condition is met, an active stimulus is reactivated.
+    /// Delayed stimuli are always polled
+    istimulus& delay(std::chrono::nanoseconds);
+    /// Delays the action by the count of polls after the condition is met.
+    /// Ticks advance only while the worker polls other stimuli, with none left to poll the action runs right away
+    istimulus& delay(ticks);
+    /// Sets clock for delays, returns false if any polled stimulus is active
+    static bool clock(clock_type);
+    /// Returns clock for delays
+    static clock_type clock() noexcept;
+    /// Advances the simulated clock and runs actions, which delays have expired
+    static void advance(std::chrono::nanoseconds);
+    /// Returns statistics of stimuli
+    static stats_type stats();
+    /// Resets statistics of stimuli
+    static void reset_stats();
+    /// Returns count of evaluations of the stimulus condition
+    std::uint64_t evaluations() const noexcept {
+        return std::atomic_ref { evaluations_ }.load(std::memory_order_relaxed);
+    }
 protected:
     constexpr istimulus(std::source_location location = std::source_location::current())
       : location_ {location} {}
@@ -70,10 +156,18 @@ protected:
     /// deactivates the stimulus
     static bool deactivate(istimulus&);
 private:
-    /// returns associated memory spans
+    /// returns associated memory spans, the watched one first
     virtual spans_type spans() = 0;
+    /// evaluates the stimulus condition
+    virtual bool triggered() = 0;
+    /// runs the stimulus action
+    virtual void perform() = 0;
+    /// evaluates the stimulus condition and counts the evaluation
+    bool evaluate();
+    /// runs the action and counts it with its latency since the condition was met at the steady time in nanoseconds
+    void complete(std::uint64_t met);
     /// runs the stimulus logic
-    virtual status_type run() = 0;
+    status_type run();
     void active() { status_ = status_type::active; }
     void inactive() { status_ = status_ == status_type::done ? status_ : status_type::idle; }
     status_type running() {
@@ -85,7 +179,17 @@ private:
     }
     std::source_location location_;
     status_type status_ {};
+    unsigned group_ { no_group };
+    /// spans, cached on activation
+    spans_type spans_ {};
+    std::chrono::nanoseconds delay_time_ {};
+    ticks delay_ticks_ {};
+    /// updated by the evaluating thread only, read by others
+    alignas(std::atomic_ref<std::uint64_t>::required_alignment) mutable std::uint64_t evaluations_ {};
     friend class stimulator;
+    friend class shard;
+    friend class trapper;
+    friend class write_watcher;
 };
 
 template<std::integral Watch, std::integral Modify, condition<Watch> Condition, action<Modify> Action>
@@ -151,12 +255,11 @@ private:
             detail::make_span(modify_),
         };
     }
-    status_type run() override {
-        if(condition_(*watch_)) {
-            action_(*modify_);
-            return status_type::done;
-        } else
-            return status_type::idle;
+    bool triggered() override {
+        return condition_(*watch_);
+    }
+    void perform() override {
+        action_(*modify_);
     }
     Condition condition_ {};
     Action action_ {};
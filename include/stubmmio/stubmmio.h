@@ -8,11 +8,19 @@
  */
 
 #pragma once
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <chrono>
+#include <cstddef>
 #include <initializer_list>
 #include <functional>
 #include <map>
 #include <source_location>
+#include <span>
 #include <stdexcept>
+#include <string>
+#include <vector>
 #include <stubmmio/types.h>
 #include <stubmmio/operators.h>
 
@@ -30,6 +38,73 @@ public:
     static std::uintptr_t size() noexcept { return size_; }
     static bool check_boundary(std::uintptr_t size = max_size, onfail on_fail = onfail::throws);
     static bool check_pagesize(int pagesize, onfail on_fail = onfail::throws);
+    /// returns number of page ranges currently allocated in the arena
+    static std::size_t allocation_count() noexcept;
+    /// returns number of page ranges mapped by the arena so far
+    static std::size_t mapping_count() noexcept;
+    /// reserves the whole arena address space up front, must be called before any allocation
+    /// allocations then change protection of the reserved pages instead of mapping new ones
+    static bool reserve(onfail on_fail = onfail::throws);
+    /// releases reserved arena address space, must be called after all pages are deallocated
+    static bool release(onfail on_fail = onfail::throws);
+    /// returns true if the arena address space is reserved
+    static bool reserved() noexcept;
+    /// starts or stops tracking pages written since they were applied, by write protecting them until written
+    static void track_writes(bool on = true);
+    /// returns true if written pages are tracked
+    static bool tracks_writes() noexcept;
+    /// returns contiguous ranges of pages written since they were applied
+    static std::vector<region> written();
+    /// returns true if any page of the region may have been written since it was applied,
+    /// that is, it is written, or writes to it are not tracked
+    static bool written(const region&);
+    /// marks all allocated pages as not written
+    static void clean_writes();
+    /// prefaulting of allocated pages: none - each page faults on its first access,
+    /// populate - pages are populated with MAP_POPULATE, or with MADV_POPULATE_WRITE if the range is reserved or huge paged,
+    /// populate_write - pages are populated with MADV_POPULATE_WRITE (Linux 5.14+)
+    enum class prefault_type : std::uint8_t { none, populate, populate_write };
+    /// policy of allocating page ranges of at least threshold bytes
+    struct policy_type {
+        prefault_type prefault;
+        bool hugepages;             ///< advises transparent huge pages with MADV_HUGEPAGE
+        std::size_t threshold;
+    };
+    /// sets policy of allocating large page ranges, such as external SDRAM or flash windows
+    static void policy(const policy_type&) noexcept;
+    /// returns policy of allocating large page ranges
+    static policy_type policy() noexcept;
+    /// metrics of the arena, accumulated since start or the last reset_metrics()
+    struct metrics_type {
+        /// count and total time of operations
+        struct operations_type {
+            std::uint64_t count;
+            std::chrono::nanoseconds time;
+        };
+        /// mappings of pages, allocated by stubs defined at the location
+        struct site_type {
+            std::source_location location;
+            operations_type map;
+        };
+        operations_type map;            ///< mappings of allocated pages, with mmap, or madvise and mprotect if reserved
+        operations_type unmap;          ///< unmappings of deallocated pages
+        operations_type fill;           ///< stores of the value, set by set_page_fill, into allocated pages
+        std::size_t mapped_bytes;       ///< currently allocated bytes
+        std::size_t peak_mapped_bytes;  ///< maximum of allocated bytes
+        std::size_t allocations;        ///< currently allocated page ranges
+        std::size_t listeners;          ///< subscribers to deallocations
+        std::uint64_t minor_faults;     ///< page faults of the process, sampled with getrusage
+        std::uint64_t major_faults;
+        std::vector<site_type> sites;   ///< ordered by descending mapping time
+        /// returns the metrics as a JSON object
+        std::string json() const;
+        /// returns the metrics in Prometheus text format
+        std::string prometheus() const;
+    };
+    /// returns metrics of the arena
+    static metrics_type metrics();
+    /// resets metrics of the arena, page faults are counted from now on
+    static void reset_metrics();
 private:
     inline static std::uintptr_t size_ = max_size;
 };
@@ -53,12 +128,30 @@ struct conflicting_allocation final : std::logic_error {
 struct page_is_not_allocated final : std::logic_error {
     using std::logic_error::logic_error;
 };
+struct snapshot_is_stale final : std::logic_error {
+    using std::logic_error::logic_error;
+};
 struct arena_is_not_fully_available final : std::runtime_error {
     using std::runtime_error::runtime_error;
 };
+struct arena_is_not_reservable final : std::runtime_error {
+    using std::runtime_error::runtime_error;
+};
 struct access_to_unallocated_address final : std::runtime_error {
     using std::runtime_error::runtime_error;
 };
+struct bad_trace_format final : std::runtime_error {
+    using std::runtime_error::runtime_error;
+};
+struct bad_svd_format final : std::runtime_error {
+    using std::runtime_error::runtime_error;
+};
+struct unknown_peripheral final : std::logic_error {
+    using std::logic_error::logic_error;
+};
+struct stimulus_deadlock final : std::logic_error {
+    using std::logic_error::logic_error;
+};
 }
 
 namespace detail {
@@ -175,6 +268,8 @@ public:
     constexpr auto addr() const noexcept { return region_.addr(); }
     constexpr auto size() const noexcept { return region_.size(); }
     constexpr auto& location() const noexcept { return location_; }
+    /// returns the operator of this element
+    auto& operation() const noexcept { return operator_; }
     template<typename T = void>
     auto begin() const noexcept { return region_.begin(); }
     template<typename T = void>
@@ -184,10 +279,134 @@ public:
     }
 private:
     region region_;
-    operator_type operator_; // std::function here makes element non-constexpr
+    operator_type operator_; // type erased operator here makes element non-constexpr
     std::source_location location_;
 };
 
+namespace detail {
+enum class static_kind : std::uint8_t { none, one, all };
+/// element of a static stub, its value is kept in the stub's data table at offset
+struct static_record {
+    region::address_type address {};
+    region::size_type size {};
+    std::size_t offset {};
+    std::size_t value_size {};
+    static_kind kind {};
+    std::source_location location {};
+};
+/// page aligned address range, allocated for a static stub
+struct static_pages {
+    region::address_type address {};
+    region::size_type size {};
+};
+/// view of a static stub tables
+struct static_table {
+    std::span<const static_record> records {};
+    std::span<const std::byte> data {};
+    std::span<const static_pages> pages {};
+    constexpr bool empty() const noexcept { return records.empty(); }
+};
+/// writes value of a static element
+void apply(const static_record& record, std::span<const std::byte> data) noexcept;
+// not defined on purpose, evaluating a call in a static stub constructor fails compilation
+void static_stub_has_overlapping_elements();
+void static_fill_size_is_not_multiple_of_value_size();
+} // namespace detail
+
+/// compile time element, initialized with a value
+template<trivial_data Type>
+struct static_element {
+    static constexpr std::size_t value_size = sizeof(Type);
+    static constexpr auto kind = detail::static_kind::one;
+    consteval static_element(address addr, const Type& data, std::source_location loc = std::source_location::current())
+      : area { addr, sizeof(Type) }, value { data }, location { loc } {}
+    consteval auto bytes() const noexcept { return std::bit_cast<std::array<std::byte, sizeof(Type)>>(value); }
+    region area;
+    Type value;
+    std::source_location location;
+};
+
+/// compile time element, filled with a value
+template<trivial_data Type>
+struct static_fill {
+    static constexpr std::size_t value_size = sizeof(Type);
+    static constexpr auto kind = detail::static_kind::all;
+    consteval static_fill(region region, const Type& data, std::source_location loc = std::source_location::current())
+      : area { region }, value { data }, location { loc } {
+        if (area.size() % sizeof(Type) != 0)
+            detail::static_fill_size_is_not_multiple_of_value_size();
+    }
+    consteval auto bytes() const noexcept { return std::bit_cast<std::array<std::byte, sizeof(Type)>>(value); }
+    region area;
+    Type value;
+    std::source_location location;
+};
+
+/// compile time uninitialized element
+struct static_region {
+    static constexpr std::size_t value_size = 0;
+    static constexpr auto kind = detail::static_kind::none;
+    consteval static_region(region region, std::source_location loc = std::source_location::current())
+      : area { region }, location { loc } {}
+    consteval auto bytes() const noexcept { return std::array<std::byte, 0>{}; }
+    region area;
+    std::source_location location;
+};
+
+/// static_stub - constant table of stub elements, built and checked for overlapping in compile time
+/// applied with a stub, constructed from it, without copying the elements
+template<std::size_t Elements, std::size_t Bytes>
+class static_stub {
+public:
+    template<typename... Element>
+    requires (sizeof...(Element) == Elements)
+    consteval static_stub(const Element&... elements) {
+        std::size_t index = 0;
+        std::size_t offset = 0;
+        (add(elements, index, offset), ...);
+        std::ranges::sort(records_, {}, &detail::static_record::address);
+        for(std::size_t i = 1; i < Elements; ++i) {
+            const auto& prev = records_[i - 1];
+            if (prev.address == records_[i].address || prev.address + prev.size > records_[i].address)
+                detail::static_stub_has_overlapping_elements();
+        }
+        for(const auto& record : records_) add_pages(record);
+    }
+    constexpr detail::static_table table() const noexcept {
+        return { records_, data_, std::span{pages_}.first(page_count_) };
+    }
+    static constexpr auto element_count() noexcept { return Elements; }
+    /// returns number of page ranges, the elements occupy
+    constexpr auto page_range_count() const noexcept { return page_count_; }
+private:
+    template<typename Element>
+    consteval void add(const Element& element, std::size_t& index, std::size_t& offset) {
+        records_[index++] = { element.area.addr(), element.area.size(), offset, Element::value_size, Element::kind, element.location };
+        const auto bytes = element.bytes();
+        std::ranges::copy(bytes, data_.begin() + static_cast<std::ptrdiff_t>(offset));
+        offset += bytes.size();
+    }
+    consteval void add_pages(const detail::static_record& record) {
+        using detail::page_size;
+        if (record.size == 0) return;
+        const auto begin = record.address / page_size * page_size;
+        const auto end = (record.address + record.size + page_size - 1) / page_size * page_size;
+        if (page_count_ != 0 && begin <= pages_[page_count_ - 1].address + pages_[page_count_ - 1].size) {
+            auto& last = pages_[page_count_ - 1];
+            last.size = std::max(last.address + last.size, end) - last.address;
+        } else {
+            pages_[page_count_++] = { begin, end - begin };
+        }
+    }
+    std::array<detail::static_record, Elements> records_ {};
+    std::array<std::byte, Bytes> data_ {};
+    std::array<detail::static_pages, Elements> pages_ {};
+    std::size_t page_count_ {};
+};
+
+template<typename... Element>
+static_stub(const Element&...) -> static_stub<sizeof...(Element), (std::size_t{0} + ... + Element::value_size)>;
+
 /// stub - allocates and initializes regions of MMIO memory
 class stub {
 public:
@@ -201,6 +420,14 @@ public:
     stub(initializer_list elements, std::source_location location = std::source_location::current());
     /// constructs stub from multiple lists of elements
     stub(std::initializer_list<initializer_list> lists, std::source_location location = std::source_location::current());
+    /// constructs stub from elements, built at run time
+    explicit stub(elements_type elements, std::source_location location = std::source_location::current());
+    /// constructs stub from a static stub, which must outlive this stub
+    template<std::size_t Elements, std::size_t Bytes>
+    stub(const static_stub<Elements, Bytes>& elements, std::source_location location = std::source_location::current())
+      : table_ { elements.table() }, location_ { location } {}
+    template<std::size_t Elements, std::size_t Bytes>
+    stub(const static_stub<Elements, Bytes>&&, std::source_location = std::source_location::current()) = delete;
     stub(const stub&) = default;
     stub(stub&&);
     stub& operator=(const stub&) = default;
@@ -219,10 +446,13 @@ public:
     stub& operator|=(stub&&);
     /// returns source location of this stub
     auto& location() const noexcept { return location_; }
-    auto element_count() const noexcept { return elements_.size(); }
+    auto element_count() const noexcept { return elements_.size() + table_.records.size(); }
 private:
     void apply() const;
+    /// converts elements of the static table to dynamic ones
+    void materialize();
     elements_type elements_ {};
+    detail::static_table table_ {};
     std::source_location location_;
 };
 
@@ -233,6 +463,19 @@ inline stub operator|(const stub& lhs, const stub& rhs) {
     return result;
 }
 
+namespace detail {
+/// contiguous range of verified memory with its expected image or fill pattern
+struct verify_step {
+    enum class kind_type : std::uint8_t { image, fill, opaque };
+    region::address_type address {};
+    region::size_type size {};
+    std::size_t offset {};       ///< offset of the image or the pattern in the verify image
+    std::size_t pattern_size {};
+    std::size_t elements {};     ///< number of elements, compared in this step
+    kind_type kind {};
+};
+} // namespace detail
+
 /// verify - verifies data in regions of MMIO memory
 class verify {
 public:
@@ -241,6 +484,14 @@ public:
     using elements_type = std::map<region::address_type, element_type>;
     using initializer_list = std::initializer_list<element_type>;
     enum class control { stop, run };
+    /// value in MMIO memory, not equal to the expected one
+    struct mismatch {
+        region::address_type address;
+        std::vector<std::byte> expected; ///< empty for elements with custom comparators
+        std::vector<std::byte> actual;
+        std::source_location location;
+    };
+    using report_type = std::vector<mismatch>;
     /// construct empty verify
     explicit verify(std::source_location location = std::source_location::current()) : location_ { location } {}
     /// construct verify from list of elements
@@ -263,12 +514,25 @@ public:
     /// return source location of this object
     auto& location() const noexcept { return location_; }
     auto element_count() const noexcept { return elements_.size(); }
+    /// runs MMIO data verification and reports every mismatch
+    report_type mismatches() const;
+    /// returns ranges of pages written since they were applied, which hold no element of this verify,
+    /// none if nothing else was written, or if arena writes are not tracked
+    std::vector<region> unverified_writes() const;
     using expect_signature = control(*)(bool, std::source_location);
     static control default_expect(bool, std::source_location);
     static constinit expect_signature expect;
 private:
     bool apply() const;
+    /// compiles elements into a plan of contiguous ranges, if they were changed since it was compiled last
+    void compile() const;
+    void ensure_allocated() const;
+    bool matches(const detail::verify_step& step) const;
     elements_type elements_ {};
+    // the plan is compiled on first use, so that appending elements one verify at a time stays linear
+    mutable std::vector<detail::verify_step> plan_ {};
+    mutable std::vector<std::byte> image_ {};
+    mutable bool stale_ { true };
     std::source_location location_;
 };
 
@@ -279,8 +543,12 @@ inline verify operator|(const verify& lhs, const verify& rhs) {
     return result;
 }
 
+/// ways to fill newly allocated pages: store - the value is stored into each page,
+/// mapped - pages are mapped copy-on-write from a template of pages filled with the value, so that unwritten pages
+/// cost neither a store nor private memory, falls back to store if memfd is not available
+enum class page_fill_type : std::uint8_t { store, mapped };
 /// sets fill value for newly allocated pages
-void set_page_fill(std::uint64_t value) noexcept;
+void set_page_fill(std::uint64_t value, page_fill_type type = page_fill_type::store) noexcept;
 /// resets fill value
 void set_page_nofill() noexcept;
 
@@ -0,0 +1,119 @@
+/*
+ * Copyright (C) 2025 Eugene Hutorny <eugene@hutorny.in.ua>
+ *
+ * svd.h - CMSIS-SVD register table and reset value stubs
+ *
+ * Licensed under MIT License, see full text in LICENSE
+ * or visit page https://opensource.org/license/mit/
+ */
+
+#pragma once
+#include <cstdint>
+#include <filesystem>
+#include <initializer_list>
+#include <iosfwd>
+#include <source_location>
+#include <span>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+#include <stubmmio/stubmmio.h>
+
+namespace stubmmio::svd {
+
+enum class access_type : std::uint8_t { read_write, read_only, write_only, write_once, read_write_once };
+
+/// register of the table, with its reset value masked by the reset mask
+struct register_entry {
+    std::uint64_t address;
+    std::uint64_t reset_value;
+    std::uint32_t name;        ///< offset of the name in the string pool, cluster names are prefixed with "cluster."
+    std::uint8_t size;         ///< size in bytes
+    access_type access;
+    std::uint16_t reserved;
+};
+static_assert(sizeof(register_entry) == 24 && std::is_trivially_copyable_v<register_entry>);
+
+/// peripheral of the table, its registers are contiguous in the register array and ordered by address
+struct peripheral_entry {
+    std::uint64_t address;
+    std::uint32_t name;        ///< offset of the name in the string pool
+    std::uint32_t first;       ///< index of the first register
+    std::uint32_t count;       ///< number of registers
+    std::uint32_t reserved;
+};
+static_assert(sizeof(peripheral_entry) == 24 && std::is_trivially_copyable_v<peripheral_entry>);
+
+/// register table header, followed by peripherals, registers and the string pool in host byte order
+struct table_header {
+    static constexpr std::uint32_t signature = 0x5444'5653; // "SVDT"
+    static constexpr std::uint16_t current = 1;
+    std::uint32_t magic { signature };
+    std::uint16_t version { current };
+    std::uint16_t entry_size { sizeof(register_entry) };
+    std::uint32_t peripheral_count {};
+    std::uint32_t register_count {};
+    std::uint32_t strings_size {};
+    std::uint32_t name {};           ///< offset of the device name in the string pool
+    std::uint64_t source_size {};    ///< size of the SVD file, the table is built from, 0 if unknown
+    std::int64_t source_time {};     ///< modification time of the SVD file
+};
+static_assert(sizeof(table_header) == 40 && std::is_trivially_copyable_v<table_header>);
+
+/// device - register table of a device, parsed from a CMSIS-SVD file or mapped from its binary image
+class device {
+public:
+    /// parses a CMSIS-SVD stream, throws bad_svd_format on malformed stream
+    static device parse(std::istream&);
+    /// maps a register table file, saved before, throws bad_svd_format on malformed file
+    static device map(const std::filesystem::path& table);
+    /// maps the table if it is built from the current svd file, otherwise parses the svd file and saves the table
+    static device load(const std::filesystem::path& svd, const std::filesystem::path& table);
+    device(const device&) = delete;
+    device(device&&) noexcept;
+    device& operator=(const device&) = delete;
+    device& operator=(device&&) noexcept;
+    ~device();
+    /// writes the register table to a stream
+    void save(std::ostream&) const;
+    std::string_view name() const noexcept { return name(header_->name); }
+    std::string_view name(const peripheral_entry& item) const noexcept { return name(item.name); }
+    std::string_view name(const register_entry& item) const noexcept { return name(item.name); }
+    std::span<const peripheral_entry> peripherals() const noexcept { return peripherals_; }
+    std::span<const register_entry> registers() const noexcept { return registers_; }
+    std::span<const register_entry> registers(const peripheral_entry& item) const noexcept {
+        return registers_.subspan(item.first, item.count);
+    }
+    /// returns the peripheral with given name, nullptr if there is none
+    const peripheral_entry* find(std::string_view peripheral) const noexcept;
+    /// returns the register with given name in the peripheral, nullptr if there is none
+    const register_entry* find(std::string_view peripheral, std::string_view name) const noexcept;
+    /// returns true if the table is mapped from a file
+    bool mapped() const noexcept { return mapping_ != nullptr; }
+    /// returns stub, initializing registers of the peripherals with their reset values,
+    /// throws unknown_peripheral if any of the names is not found
+    stub on_reset(std::initializer_list<std::string_view> peripherals,
+                  std::source_location location = std::source_location::current()) const {
+        return on_reset(std::span { peripherals.begin(), peripherals.size() }, location);
+    }
+    stub on_reset(std::span<const std::string_view> peripherals,
+                  std::source_location location = std::source_location::current()) const;
+    /// returns stub, initializing registers of all peripherals with their reset values
+    stub on_reset(std::source_location location = std::source_location::current()) const;
+private:
+    explicit device(std::vector<std::byte> image);
+    device(void* mapping, std::size_t size);
+    /// validates the image and binds the views to it
+    void bind(std::span<const std::byte> image);
+    std::string_view name(std::uint32_t offset) const noexcept { return strings_.data() + offset; }
+    stub on_reset(std::vector<const register_entry*> selected, std::source_location location) const;
+    std::vector<std::byte> image_ {};
+    void* mapping_ {};
+    std::size_t mapping_size_ {};
+    const table_header* header_ {};
+    std::span<const peripheral_entry> peripherals_ {};
+    std::span<const register_entry> registers_ {};
+    std::string_view strings_ {};
+};
+
+} // namespace stubmmio::svd
@@ -0,0 +1,96 @@
+/*
+ * Copyright (C) 2025 Eugene Hutorny <eugene@hutorny.in.ua>
+ *
+ * trace.h - stubmmio access trace recorder
+ *
+ * Licensed under MIT License, see full text in LICENSE
+ * or visit page https://opensource.org/license/mit/
+ */
+
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <iosfwd>
+#include <span>
+#include <string>
+#include <type_traits>
+#include <vector>
+#include <stubmmio/stubmmio.h>
+
+namespace stubmmio::trace {
+
+enum class kind_type : std::uint8_t { read, write };
+
+/// trace record, as stored in the ring buffers and in trace files
+struct record {
+    std::uint64_t timestamp; ///< steady clock time in nanoseconds
+    std::uint64_t value;     ///< value read or written, zero extended
+    std::uint32_t address;   ///< target address of the access
+    std::uint8_t width;      ///< access width in bytes, 0 if unknown
+    kind_type kind;
+    std::uint16_t thread;    ///< recording thread, numbered in order of its first record
+    friend constexpr bool operator==(const record&, const record&) noexcept = default;
+};
+static_assert(sizeof(record) == 24 && std::is_trivially_copyable_v<record>);
+
+/// trace file header, followed by records in host byte order
+struct file_header {
+    static constexpr std::uint32_t signature = 0x5254'4D53; // "SMTR"
+    static constexpr std::uint16_t current = 1;
+    std::uint32_t magic { signature };
+    std::uint16_t version { current };
+    std::uint16_t record_size { sizeof(record) };
+};
+
+/// starts recording, each thread records into its own ring buffer of capacity records
+void start(std::size_t capacity = 1 << 16);
+/// stops recording, records kept in the ring buffers remain available for collect()
+void stop() noexcept;
+bool enabled() noexcept;
+/// traces every access to the region with page protection traps (x86-64 Linux only),
+/// returns false if traps are not supported
+bool watch(region);
+/// stops tracing accesses to the region with traps
+void unwatch(region) noexcept;
+/// takes records from all ring buffers, ordered by timestamp
+std::vector<record> collect();
+/// returns number of records lost on full ring buffers since start
+std::uint64_t dropped() noexcept;
+/// writes records to a trace file stream
+void save(std::ostream&, std::span<const record>);
+/// reads records from a trace file stream, throws bad_trace_format on malformed stream
+std::vector<record> load(std::istream&);
+/// formats a record as a line of text
+std::string format(const record&);
+
+template<typename Type>
+concept register_type = std::is_integral_v<Type> && !std::is_same_v<Type, bool>;
+
+namespace detail {
+inline constinit std::atomic<bool> enabled_ {};
+void append(const volatile void* address, std::uint8_t width, std::uint64_t value, kind_type) noexcept;
+
+template<typename Type>
+constexpr std::uint64_t widen(Type value) noexcept {
+    return static_cast<std::uint64_t>(static_cast<std::make_unsigned_t<Type>>(value));
+}
+} // namespace detail
+
+/// instrumented register read, recorded while tracing is enabled
+template<register_type Type>
+inline Type read(const volatile Type* address) noexcept {
+    const Type value = *address;
+    if (detail::enabled_.load(std::memory_order_relaxed))
+        detail::append(address, sizeof(Type), detail::widen(value), kind_type::read);
+    return value;
+}
+
+/// instrumented register write, recorded while tracing is enabled
+template<register_type Type>
+inline void write(volatile Type* address, std::type_identity_t<Type> value) noexcept {
+    *address = value;
+    if (detail::enabled_.load(std::memory_order_relaxed))
+        detail::append(address, sizeof(Type), detail::widen(value), kind_type::write);
+}
+
+} // namespace stubmmio::trace
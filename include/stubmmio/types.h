@@ -17,6 +17,7 @@ enum class address : std::uintptr_t {};
 
 namespace detail {
 
+inline constexpr std::size_t page_size = 4096;
 using volatile_span = std::span<const volatile char>;
 
 } // namespace detail
@@ -9,9 +9,15 @@
 
 #include <stubmmio/stubmmio.h>
 #include <stubmmio/logger.h>
+#include <algorithm>
+#include <cstring>
 #include <format>
+#include <fstream>
+#include <functional>
 #include <iostream>
-#include "pagerange.h"
+#include <string_view>
+#include <sys/resource.h>
+#include "mmio.h"
 
 extern "C" const uint64_t __executable_start;
 
@@ -33,6 +39,41 @@ bool failed(onfail on_fail, std::string&& message) {
         return false;
     }
 }
+/// returns lowest address, available for mmap, as configured with vm.mmap_min_addr
+std::uintptr_t mmap_min_addr() {
+    static constexpr std::uintptr_t default_min_addr = 0x10000;
+    std::uintptr_t result = default_min_addr;
+    std::ifstream { "/proc/sys/vm/mmap_min_addr" } >> result;
+    return (result + detail::page_size - 1) / detail::page_size * detail::page_size;
+}
+
+detail::pagerange reservation_range() {
+    return { reinterpret_cast<const void*>(mmap_min_addr()), reinterpret_cast<const void*>(arena::size()) };
+}
+
+/// page faults of the process, when metrics were reset
+rusage faults_baseline {};
+
+rusage usage() noexcept {
+    rusage result {};
+    getrusage(RUSAGE_SELF, &result);
+    return result;
+}
+
+/// returns the text as a quoted string, valid in JSON and in Prometheus labels
+std::string quoted(std::string_view text) {
+    std::string result { '"' };
+    for(const auto c : text) {
+        if (c == '"' || c == '\\') result += '\\';
+        result += c;
+    }
+    result += '"';
+    return result;
+}
+
+double seconds(std::chrono::nanoseconds time) noexcept {
+    return std::chrono::duration<double>(time).count();
+}
 } // namespace
 
 bool arena::check_pagesize(int actual, onfail on_fail) {
@@ -54,4 +95,135 @@ bool arena::check_boundary(std::uintptr_t arena_boundary, onfail on_fail) {
     return true;
 }
 
+bool arena::reserve(onfail on_fail) {
+    auto& mmio = detail::mmio::arena();
+    if (mmio.reserved())
+        return true;
+    const auto range = reservation_range();
+    if (mmio.allocation_count() != 0) {
+        return failed<arena_is_not_reservable>(on_fail, std::format(
+              "Arena {}[{}] can only be reserved before any allocation", range.pointer(), range.size_bytes()));
+    }
+    if (const auto err = mmio.reserve(range); err != 0) {
+        return failed<arena_is_not_reservable>(on_fail, std::format(
+              "Reserving arena {}[{}] has failed: {} - {}", range.pointer(), range.size_bytes(), err, strerror(err)));
+    }
+    return true;
+}
+
+bool arena::release(onfail on_fail) {
+    auto& mmio = detail::mmio::arena();
+    if (mmio.allocation_count() != 0) {
+        return failed<arena_is_not_reservable>(on_fail, std::format(
+              "Arena can only be released after all pages are deallocated, {} are still allocated",
+              mmio.allocation_count()));
+    }
+    if (const auto err = mmio.release(); err != 0) {
+        return failed<arena_is_not_reservable>(on_fail, std::format(
+              "Releasing arena has failed: {} - {}", err, strerror(err)));
+    }
+    return true;
+}
+
+bool arena::reserved() noexcept {
+    return detail::mmio::arena().reserved();
+}
+
+std::size_t arena::allocation_count() noexcept {
+    return detail::mmio::arena().allocation_count();
+}
+
+std::size_t arena::mapping_count() noexcept {
+    return detail::mmio::arena().mapping_count();
+}
+
+void arena::track_writes(bool on) {
+    detail::mmio::arena().track_writes(on);
+}
+
+bool arena::tracks_writes() noexcept {
+    return detail::mmio::arena().tracking_writes();
+}
+
+std::vector<region> arena::written() {
+    if (! tracks_writes()) return {};
+    return detail::written_pages({ std::uintptr_t { 0 }, size() });
+}
+
+bool arena::written(const region& area) {
+    return ! tracks_writes() || detail::pages_written(area);
+}
+
+void arena::clean_writes() {
+    detail::mmio::arena().clean();
+}
+
+void arena::policy(const policy_type& value) noexcept {
+    detail::mmio::arena().set_policy(value);
+}
+
+arena::policy_type arena::policy() noexcept {
+    return detail::mmio::arena().policy();
+}
+
+arena::metrics_type arena::metrics() {
+    const auto& mmio = detail::mmio::arena();
+    auto result = mmio.metrics();
+    result.allocations = mmio.allocation_count();
+    result.listeners = mmio.listener_count();
+    const auto current = usage();
+    result.minor_faults = static_cast<std::uint64_t>(current.ru_minflt - faults_baseline.ru_minflt);
+    result.major_faults = static_cast<std::uint64_t>(current.ru_majflt - faults_baseline.ru_majflt);
+    result.sites.reserve(mmio.sites().size());
+    for(const auto& item : mmio.sites()) result.sites.push_back(item.second);
+    std::ranges::sort(result.sites, std::greater {}, [](const metrics_type::site_type& site) noexcept { return site.map.time; });
+    return result;
+}
+
+void arena::reset_metrics() {
+    detail::mmio::arena().reset_metrics();
+    faults_baseline = usage();
+}
+
+std::string arena::metrics_type::json() const {
+    auto result = std::format("{{\"map\": {{\"count\": {}, \"seconds\": {}}}, \"unmap\": {{\"count\": {}, \"seconds\": {}}}, "
+        "\"fill\": {{\"count\": {}, \"seconds\": {}}}, \"mapped_bytes\": {}, \"peak_mapped_bytes\": {}, "
+        "\"allocations\": {}, \"listeners\": {}, \"minor_faults\": {}, \"major_faults\": {}, \"sites\": [",
+        map.count, seconds(map.time), unmap.count, seconds(unmap.time), fill.count, seconds(fill.time),
+        mapped_bytes, peak_mapped_bytes, allocations, listeners, minor_faults, major_faults);
+    for(const char* separator = ""; const auto& site : sites) {
+        result += std::format("{}{{\"file\": {}, \"line\": {}, \"map\": {{\"count\": {}, \"seconds\": {}}}}}",
+            separator, quoted(site.location.file_name()), site.location.line(), site.map.count, seconds(site.map.time));
+        separator = ", ";
+    }
+    result += "]}";
+    return result;
+}
+
+std::string arena::metrics_type::prometheus() const {
+    std::string result {};
+    const auto metric = [&result](std::string_view name, std::string_view type, auto value) {
+        result += std::format("# TYPE stubmmio_arena_{} {}\nstubmmio_arena_{} {}\n", name, type, name, value);
+    };
+    metric("map_total", "counter", map.count);
+    metric("map_seconds_total", "counter", seconds(map.time));
+    metric("unmap_total", "counter", unmap.count);
+    metric("unmap_seconds_total", "counter", seconds(unmap.time));
+    metric("fill_total", "counter", fill.count);
+    metric("fill_seconds_total", "counter", seconds(fill.time));
+    metric("mapped_bytes", "gauge", mapped_bytes);
+    metric("peak_mapped_bytes", "gauge", peak_mapped_bytes);
+    metric("allocations", "gauge", allocations);
+    metric("listeners", "gauge", listeners);
+    metric("minor_faults_total", "counter", minor_faults);
+    metric("major_faults_total", "counter", major_faults);
+    if (sites.empty()) return result;
+    result += "# TYPE stubmmio_arena_site_map_seconds_total counter\n";
+    for(const auto& site : sites) {
+        result += std::format("stubmmio_arena_site_map_seconds_total{{file={},line=\"{}\"}} {}\n",
+            quoted(site.location.file_name()), site.location.line(), seconds(site.map.time));
+    }
+    return result;
+}
+
 } // namespace stubmmio
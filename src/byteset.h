@@ -0,0 +1,96 @@
+/*
+ * Copyright (C) 2025 Eugene Hutorny <eugene@hutorny.in.ua>
+ *
+ * src/byteset.h - ordered set of disjoint byte ranges
+ *
+ * Licensed under MIT License, see full text in LICENSE
+ * or visit page https://opensource.org/license/mit/
+ */
+
+#pragma once
+#include <algorithm>
+#include <cstdint>
+#include <initializer_list>
+#include <iterator>
+#include <optional>
+#include <vector>
+
+namespace stubmmio::detail {
+
+/// addresses [first, last)
+struct byterange {
+    std::uintptr_t first;
+    std::uintptr_t last;
+    constexpr bool empty() const noexcept { return last <= first; }
+    constexpr auto size() const noexcept { return last - first; }
+    constexpr bool operator==(const byterange&) const noexcept = default;
+};
+
+/// ordered set of disjoint byte ranges, adjacent and overlapping ranges are coalesced
+class byteset {
+public:
+    using ranges_type = std::vector<byterange>;
+    byteset() = default;
+    byteset(std::initializer_list<byterange> ranges) {
+        for(const auto& range : ranges) append(range);
+    }
+
+    auto begin() const noexcept { return ranges_.begin(); }
+    auto end() const noexcept { return ranges_.end(); }
+    auto size() const noexcept { return ranges_.size(); }
+    auto empty() const noexcept { return ranges_.empty(); }
+    bool operator==(const byteset&) const noexcept = default;
+
+    /// adds a range, starting not before any range of the set
+    void append(byterange range) {
+        if (range.empty()) return;
+        if (! ranges_.empty() && range.first <= ranges_.back().last)
+            ranges_.back().last = std::max(ranges_.back().last, range.last);
+        else
+            ranges_.push_back(range);
+    }
+    /// returns ranges of the set, clipped to the window
+    byteset within(byterange window) const {
+        byteset result {};
+        for(auto i = std::ranges::upper_bound(ranges_, window.first, {}, &byterange::last);
+            i != ranges_.end() && i->first < window.last; ++i) {
+            result.append({std::max(i->first, window.first), std::min(i->last, window.last)});
+        }
+        return result;
+    }
+    /// replaces ranges of the set within the window with those of the other set
+    void assign(byterange window, const byteset& other) {
+        byteset result {};
+        for(const auto& range : ranges_) {
+            if (range.first < window.first) result.append({range.first, std::min(range.last, window.first)});
+        }
+        for(const auto& range : other.within(window)) result.append(range);
+        for(const auto& range : ranges_) {
+            if (window.last < range.last) result.append({std::max(range.first, window.last), range.last});
+        }
+        ranges_ = std::move(result.ranges_);
+    }
+    /// adds ranges of the other set
+    void merge(const byteset& other) {
+        ranges_type merged {};
+        merged.reserve(ranges_.size() + other.ranges_.size());
+        std::ranges::merge(ranges_, other.ranges_, std::back_inserter(merged), {}, &byterange::first, &byterange::first);
+        ranges_.clear();
+        for(const auto& range : merged) append(range);
+    }
+    /// returns the first range where the sets overlap
+    std::optional<byterange> overlap(const byteset& other) const noexcept {
+        auto lhs = ranges_.begin();
+        auto rhs = other.ranges_.begin();
+        while(lhs != ranges_.end() && rhs != other.ranges_.end()) {
+            if (lhs->last <= rhs->first) ++lhs;
+            else if (rhs->last <= lhs->first) ++rhs;
+            else return byterange{std::max(lhs->first, rhs->first), std::min(lhs->last, rhs->last)};
+        }
+        return std::nullopt;
+    }
+private:
+    ranges_type ranges_ {};
+};
+
+} // namespace stubmmio::detail
@@ -0,0 +1,120 @@
+/*
+ * Copyright (C) 2025 Eugene Hutorny <eugene@hutorny.in.ua>
+ *
+ * src/compare.cxx - vectorized memory comparison kernels
+ *
+ * Licensed under MIT License, see full text in LICENSE
+ * or visit page https://opensource.org/license/mit/
+ */
+
+#include "compare.h"
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstdint>
+#include <cstring>
+#if defined(__x86_64__)
+#include <immintrin.h>
+#endif
+
+namespace stubmmio::detail {
+namespace {
+
+std::size_t mismatch_scalar(const std::byte* data, const std::byte* image, std::size_t size) noexcept {
+    std::size_t offset = 0;
+    for(; offset + sizeof(std::uint64_t) <= size; offset += sizeof(std::uint64_t)) {
+        std::uint64_t lhs, rhs;
+        std::memcpy(&lhs, data + offset, sizeof(lhs));
+        std::memcpy(&rhs, image + offset, sizeof(rhs));
+        if (lhs != rhs) {
+            if constexpr (std::endian::native == std::endian::little)
+                return offset + static_cast<std::size_t>(std::countr_zero(lhs ^ rhs)) / 8;
+            else
+                return offset + static_cast<std::size_t>(std::countl_zero(lhs ^ rhs)) / 8;
+        }
+    }
+    for(; offset < size; ++offset) {
+        if (data[offset] != image[offset]) return offset;
+    }
+    return size;
+}
+
+#if defined(__x86_64__)
+std::size_t mismatch_sse2(const std::byte* data, const std::byte* image, std::size_t size) noexcept {
+    constexpr std::size_t width = sizeof(__m128i);
+    std::size_t offset = 0;
+    for(; offset + width <= size; offset += width) {
+        const auto lhs = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + offset));
+        const auto rhs = _mm_loadu_si128(reinterpret_cast<const __m128i*>(image + offset));
+        const auto equal = static_cast<unsigned>(_mm_movemask_epi8(_mm_cmpeq_epi8(lhs, rhs)));
+        if (equal != 0xFFFFU)
+            return offset + static_cast<std::size_t>(std::countr_one(equal));
+    }
+    return offset + mismatch_scalar(data + offset, image + offset, size - offset);
+}
+
+__attribute__((target("avx2")))
+std::size_t mismatch_avx2(const std::byte* data, const std::byte* image, std::size_t size) noexcept {
+    constexpr std::size_t width = sizeof(__m256i);
+    std::size_t offset = 0;
+    for(; offset + width <= size; offset += width) {
+        const auto lhs = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + offset));
+        const auto rhs = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(image + offset));
+        const auto equal = static_cast<unsigned>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(lhs, rhs)));
+        if (equal != 0xFFFFFFFFU)
+            return offset + static_cast<std::size_t>(std::countr_one(equal));
+    }
+    return offset + mismatch_sse2(data + offset, image + offset, size - offset);
+}
+#endif
+
+using kernel_type = std::size_t(*)(const std::byte*, const std::byte*, std::size_t) noexcept;
+
+kernel_type select_kernel() noexcept {
+#if defined(__x86_64__)
+    // CPU features are only valid after initialization, which may not have run yet in a static initializer
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx2") ? &mismatch_avx2 : &mismatch_sse2;
+#else
+    return &mismatch_scalar;
+#endif
+}
+
+/// the kernel is selected on first use, a verify may run from a static initializer of another translation unit
+kernel_type kernel() noexcept {
+    static const kernel_type selected = select_kernel();
+    return selected;
+}
+
+} // namespace
+
+std::size_t find_mismatch(const std::byte* data, const std::byte* image, std::size_t size) noexcept {
+    return kernel()(data, image, size);
+}
+
+std::size_t find_mismatch(const std::byte* data, std::size_t size, const std::byte* pattern, std::size_t pattern_size) noexcept {
+    if (pattern_size == 0) return size;
+    const auto compare = kernel();
+    if (pattern_size > 256) {
+        for(std::size_t offset = 0; offset < size; offset += pattern_size) {
+            const auto chunk = std::min(pattern_size, size - offset);
+            if (const auto found = compare(data + offset, pattern, chunk); found != chunk)
+                return offset + found;
+        }
+        return size;
+    }
+    // the pattern is repeated to a block of whole patterns, which is compared with the data block by block
+    std::array<std::byte, 256> block;
+    const auto block_size = std::min(block.size() / pattern_size, std::max<std::size_t>(1, size / pattern_size)) * pattern_size;
+    for(std::size_t offset = 0; offset < block_size; offset += pattern_size)
+        std::memcpy(block.data() + offset, pattern, pattern_size);
+    std::size_t offset = 0;
+    for(; offset < size; offset += block_size) {
+        const auto chunk = std::min(block_size, size - offset);
+        if (const auto found = compare(data + offset, block.data(), chunk); found != chunk)
+            return offset + found;
+    }
+    return size;
+}
+
+} // namespace stubmmio::detail
@@ -0,0 +1,20 @@
+/*
+ * Copyright (C) 2025 Eugene Hutorny <eugene@hutorny.in.ua>
+ *
+ * src/compare.h - vectorized memory comparison kernels
+ *
+ * Licensed under MIT License, see full text in LICENSE
+ * or visit page https://opensource.org/license/mit/
+ */
+
+#pragma once
+#include <cstddef>
+
+namespace stubmmio::detail {
+
+/// returns offset of the first byte of data, not equal to image, or size if all bytes are equal
+std::size_t find_mismatch(const std::byte* data, const std::byte* image, std::size_t size) noexcept;
+/// returns offset of the first byte of data, not equal to the repeated pattern, or size if all bytes are equal
+std::size_t find_mismatch(const std::byte* data, std::size_t size, const std::byte* pattern, std::size_t pattern_size) noexcept;
+
+} // namespace stubmmio::detail
@@ -11,18 +11,61 @@
 
 #include <stubmmio/stubmmio.h>
 #include <stubmmio/logger.h>
+#include "byteset.h"
 #include "pagerange.h"
+#include "pageindex.h"
+#include "trap.h"
 #include <sys/mman.h>
+#include <unistd.h>
 #include <errno.h>
+#include <algorithm>
+#include <chrono>
 #include <cstring>
 #include <iostream>
 #include <format>
 #include <optional>
 #include <span>
 #include <source_location>
+#include <string_view>
+#include <utility>
 #include <vector>
 
 namespace stubmmio::detail {
+/// addresses of the pages
+inline byterange bytes_of(pagerange pr) noexcept {
+    const auto first = reinterpret_cast<std::uintptr_t>(pr.pointer());
+    return { first, first + pr.size_bytes() };
+}
+
+/// pages [first, last)
+inline pagerange pages_of(pageid_type first, pageid_type last) noexcept {
+    return { reinterpret_cast<void*>(std::uintptr_t{first} * page_size), reinterpret_cast<void*>(std::uintptr_t{last} * page_size) };
+}
+
+/// fill_template - file of pages filled with the fill value, mapped copy-on-write into allocated ranges,
+/// so that pages not written share the pages of the file
+class fill_template {
+public:
+    fill_template() = default;
+    fill_template(const fill_template&) = delete;
+    fill_template(fill_template&&) = delete;
+    fill_template& operator=(const fill_template&) = delete;
+    fill_template& operator=(fill_template&&) = delete;
+    ~fill_template() { close(); }
+    /// maps the range from the template of the value, returns false if the template is not available
+    bool map(pagerange, std::uint64_t value, bool populate);
+private:
+    /// largest size of the template, a larger range is mapped by parts of this size
+    static constexpr std::size_t max_size = 2 * 1024 * 1024;
+    /// grows the template of the value to the size
+    bool prepare(std::size_t size, std::uint64_t value) noexcept;
+    void close() noexcept;
+    int fd_ { -1 };
+    std::size_t size_ {};
+    std::uint64_t value_ {};
+    bool failed_ {};
+};
+
 class mmio {
 public:
     ~mmio();
@@ -31,37 +74,118 @@ public:
     mmio& operator=(const mmio&) = delete;
     mmio& operator=(mmio&&) = delete;
     static mmio& arena();
-    void allocate(pagerange, const stub& owner);
+    /// allocates pages for the bytes of the owner, pages shared with other owners stay mapped
+    void allocate(pagerange, const stub& owner, const byteset& bytes);
+    /// allocates pages for all their bytes
+    void allocate(pagerange pages, const stub& owner) {
+        allocate(pages, owner, {bytes_of(pages)});
+    }
     void deallocate(const stub& owner);
     void claim(const stub& looser, const stub& claimer);
     std::size_t allocation_size() const;
+    std::size_t allocation_count() const noexcept {
+        return allocations_.size();
+    }
+    std::size_t mapping_count() const noexcept {
+        return mappings_;
+    }
     bool contains(pagerange) const;
     bool contains(volatile_span) const;
-    void set_fill(std::uint64_t value) noexcept {
+    void set_fill(std::uint64_t value, page_fill_type type) noexcept {
         fill_ = value;
+        fill_type_ = type;
     }
     void set_nofill() noexcept {
         fill_.reset();
     }
+    void set_policy(const arena::policy_type& value) noexcept {
+        policy_ = value;
+    }
+    const auto& policy() const noexcept {
+        return policy_;
+    }
+    /// allocated page range and serial number of its mapping
+    struct mapping {
+        pagerange range;
+        std::uint64_t serial;
+    };
+    std::vector<mapping> mappings() const;
+    bool mapped(const mapping&) const;
+    /// replaces allocated pages with a private copy-on-write mapping of the file
+    void remap(const mapping&, int fd, off_t offset);
     struct listener {
         virtual ~listener() {}
         virtual void unmapping(volatile_span, std::source_location) = 0;
     };
     void subscribe(listener*);
     void unsubscribe(listener*);
+    /// reserves the range, so that allocations only change protection of its pages, returns errno
+    int reserve(pagerange) noexcept;
+    /// releases reserved range, returns errno
+    int release() noexcept;
+    bool reserved() const noexcept {
+        return reservation_.has_value();
+    }
+    /// starts or stops tracking writes to allocated pages
+    void track_writes(bool on);
+    bool tracking_writes() const noexcept {
+        return tracking_;
+    }
+    /// marks pages as not written, if writes are tracked, and protects the pages mapped anew as they were before
+    void clean(pagerange);
+    /// marks all allocated pages as not written
+    void clean();
+    /// changes each time pages may be marked not written without being restored
+    auto tracking_epoch() const noexcept {
+        return tracking_epoch_;
+    }
+    /// metrics, other than page faults, allocations and listeners
+    const auto& metrics() const noexcept {
+        return metrics_;
+    }
+    /// mappings of pages by the source location of the owner
+    const auto& sites() const noexcept {
+        return sites_;
+    }
+    std::size_t listener_count() const noexcept {
+        return listeners_.size();
+    }
+    void reset_metrics() noexcept;
 private:
-    void validate(pagerange, const stub& owner) const;
-    struct allocation {
-        pagerange range;
+    void validate(pagerange, const stub& owner, const byteset& bytes) const;
+    /// bytes of allocated pages, owned by a stub
+    struct share {
         stub::identity_type owner;
         std::source_location location;
+        byteset bytes;
+    };
+    struct allocation {
+        pagerange range;
+        std::vector<share> owners;  ///< pages are unmapped when the last owner deallocates them
+        std::uint64_t serial;
+        bool imaged;        ///< mapped from a file, a snapshot image or the fill template
     };
-    void map(pagerange);
+    /// maps pages anew, absorbing allocations of the owner
+    void map(pagerange, const stub& owner, const byteset& bytes);
+    void unmap(const allocation&) noexcept;
+    /// returns true if the policy applies to the range
+    bool large(pagerange) const noexcept;
+    /// applies the policy to a newly mapped range, populated unless already populated by mmap
+    void prefault(pagerange, bool populated) const noexcept;
     void notify(pagerange, std::source_location);
     mmio() = default;
-    std::map<pageid_type, allocation> allocations_{};
+    pageindex<allocation> allocations_{};
     std::vector<listener*> listeners_ {};
     std::optional<std::uint64_t> fill_ {};
+    page_fill_type fill_type_ {};
+    fill_template fill_template_ {};
+    arena::policy_type policy_ {};
+    std::size_t mappings_ {};
+    std::optional<pagerange> reservation_ {};
+    bool tracking_ {};
+    std::uint64_t tracking_epoch_ {};
+    arena::metrics_type metrics_ {};
+    std::map<std::pair<std::string_view, std::uint_least32_t>, arena::metrics_type::site_type> sites_ {};
 };
 
 using log = logovod::logger<logcategory::arena>;
@@ -71,19 +195,99 @@ inline mmio& mmio::arena() {
     return instance;
 }
 
+[[noreturn]] inline void report_system_error(std::string_view call, pagerange pr) {
+    auto err = errno;
+    auto msg = std::format("{}({}, {}) has failed: {} - {}", call, pr.pointer(), pr.size_bytes(), err, strerror(err));
+    log::critical{}(msg);
+    throw std::system_error{{err, std::system_category()}, msg};
+}
+
+inline void log_system_error(std::string_view call, pagerange pr) noexcept {
+    auto err = errno;
+    log::error{}.format("{}({}, {}) has failed: {} - {}", call, pr.pointer(), pr.size_bytes(), err, strerror(err));
+}
+
+#ifdef MADV_POPULATE_WRITE
+inline constexpr int populate_write = MADV_POPULATE_WRITE;
+#else
+inline constexpr int populate_write = 23; // since Linux 5.14
+#endif
+
+inline volatile_span span_of(pagerange pr) noexcept {
+    return { static_cast<volatile_span::element_type*>(pr.pointer()), pr.size_bytes() };
+}
+
 inline void unmap_range(pagerange pr) {
     munmap(pr.pointer(), pr.size_bytes());
 }
 
+/// maps pages of the range as inaccessible, reserving them for later allocation
+inline void reserve_range(pagerange pr) noexcept {
+    static constexpr int flags =  MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE | MAP_FIXED;
+    if (mmap(pr.pointer(), pr.size_bytes(), PROT_NONE, flags, -1, 0) == MAP_FAILED)
+        log_system_error("mmap", pr);
+}
+
+/// makes reserved pages accessible and zero-filled
+inline std::span<std::uint64_t> protect_range(pagerange pr) {
+    if (madvise(pr.pointer(), pr.size_bytes(), MADV_DONTNEED) != 0)
+        report_system_error("madvise", pr);
+    if (mprotect(pr.pointer(), pr.size_bytes(), PROT_READ | PROT_WRITE) != 0)
+        report_system_error("mprotect", pr);
+    return { static_cast<std::uint64_t*>(pr.pointer()), pr.size_bytes() / sizeof(std::uint64_t) };
+}
+
+/// makes pages inaccessible and drops their content
+inline void revoke_range(pagerange pr) noexcept {
+    if (mprotect(pr.pointer(), pr.size_bytes(), PROT_NONE) != 0)
+        log_system_error("mprotect", pr);
+    if (madvise(pr.pointer(), pr.size_bytes(), MADV_DONTNEED) != 0)
+        log_system_error("madvise", pr);
+}
+
 inline mmio::~mmio() {
     for(const auto& i : allocations_) {
-        notify(i.second.range, i.second.location);
+        notify(i.second.range, i.second.owners.front().location);
+    }
+    if (reserved()) {
+        unmap_range(*reservation_);
+        return;
     }
     for(const auto& i : allocations_) {
         unmap_range(i.second.range);
     }
 }
 
+inline void mmio::unmap(const allocation& allocated) noexcept {
+    release_pages(span_of(allocated.range));
+    if (! reserved())
+        unmap_range(allocated.range);
+    else if (allocated.imaged)
+        reserve_range(allocated.range);
+    else
+        revoke_range(allocated.range);
+}
+
+inline int mmio::reserve(pagerange range) noexcept {
+    static constexpr int flags =  MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE | MAP_FIXED_NOREPLACE;
+    auto ptr = mmap(range.pointer(), range.size_bytes(), PROT_NONE, flags, -1, 0);
+    if (ptr == MAP_FAILED)
+        return errno;
+    if (ptr != range.pointer()) { // kernels prior 4.17 treat MAP_FIXED_NOREPLACE as a hint
+        munmap(ptr, range.size_bytes());
+        return EEXIST;
+    }
+    reservation_ = range;
+    return 0;
+}
+
+inline int mmio::release() noexcept {
+    if (reservation_.has_value() && munmap(reservation_->pointer(), reservation_->size_bytes()) != 0)
+        return errno;
+    reservation_.reset();
+    return 0;
+}
+
 inline void mmio::subscribe(listener* l) {
     listeners_.push_back(l);
 }
@@ -93,10 +297,28 @@ inline void mmio::unsubscribe(listener* l) {
 }
 
 inline void mmio::notify(pagerange pages, std::source_location location) {
-    const volatile_span addresses { static_cast<volatile_span::element_type*>(pages.pointer()), pages.size_bytes() };
+    const auto addresses = span_of(pages);
     for(auto l : listeners_) l->unmapping(addresses, location);
 }
 
+/// returns time elapsed since the start
+inline std::chrono::nanoseconds since(std::chrono::steady_clock::time_point start) noexcept {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start);
+}
+
+/// counts an operation, which took the time
+inline void count(arena::metrics_type::operations_type& operations, std::chrono::nanoseconds time) noexcept {
+    ++operations.count;
+    operations.time += time;
+}
+
+inline void mmio::reset_metrics() noexcept {
+    const auto mapped = metrics_.mapped_bytes;
+    metrics_ = {};
+    metrics_.mapped_bytes = metrics_.peak_mapped_bytes = mapped;
+    sites_.clear();
+}
+
 inline void report_conflicting_allocation(pagerange requested, pagerange previous, std::source_location location) {
     throw exceptions::conflicting_allocation{
         std::format("Requested allocation {}[{}] conflicts with previous {}[{}] of the same owner @ {}:{}",
@@ -104,73 +326,202 @@ inline void report_conflicting_allocation(pagerange requested, pagerange previou
                 location.file_name(), location.line())};
 }
 
-inline void report_conflicting_allocation(pagerange requested, pagerange previous, std::source_location requestor, std::source_location owner) {
+inline void report_conflicting_allocation(byterange overlap, std::source_location requestor, std::source_location owner) {
     throw exceptions::conflicting_allocation{
-        std::format("Page range {}[{}] requested by stub @ {}:{} conflicts with previous {}[{}] by another stub @ {}:{}",
-                requested.pointer(), requested.size_bytes(), requestor.file_name(), requestor.line(),
-                previous.pointer(), previous.size_bytes(), owner.file_name(), owner.line())};
-}
-
-inline void mmio::validate(pagerange requested, const stub& owner) const {
-    if(allocations_.contains(requested.begin())) {
-        const auto& previous = allocations_.at(requested.begin());
-        if (previous.owner == owner.identity()) {
-            if(previous.range == requested)
-                return; // exact page already allocated
-            report_conflicting_allocation(requested, previous.range, owner.location());
-        } else {
-            report_conflicting_allocation(requested, previous.range, owner.location(), previous.location);
+        std::format("Bytes {}[{}] requested by stub @ {}:{} are owned by another stub @ {}:{}",
+                reinterpret_cast<const void*>(overlap.first), overlap.size(), requestor.file_name(), requestor.line(),
+                owner.file_name(), owner.line())};
+}
+
+inline void mmio::validate(pagerange requested, const stub& owner, const byteset& bytes) const {
+    for(const auto& [page, previous] : allocations_.intersecting(requested)) {
+        for(const auto& other : previous.owners) {
+            if (other.owner != owner.identity()) {
+                if (const auto overlap = other.bytes.overlap(bytes))
+                    report_conflicting_allocation(*overlap, owner.location(), other.location);
+            } else if (page == requested.begin() && previous.range != requested && previous.owners.size() == 1) {
+                report_conflicting_allocation(requested, previous.range, owner.location());
+            }
         }
     }
-    auto found = std::find_if(allocations_.begin(), allocations_.end(), [requested](const auto& item) {
-        return requested.overlapping(item.second.range);
-    });
-    if (found != allocations_.end() && found->second.owner != owner.identity()) {
-        report_conflicting_allocation(requested, found->second.range, owner.location(), found->second.location);
-    }
 }
 
-inline std::span<std::uint64_t> map_range(pagerange pr) {
+inline std::span<std::uint64_t> map_range(pagerange pr, bool populate = false) {
     static constexpr int prot = PROT_READ | PROT_WRITE;
     static constexpr int flags =  MAP_PRIVATE | MAP_ANONYMOUS | MAP_FIXED;
-    auto ptr = mmap(pr.pointer(), pr.size_bytes(), prot, flags, -1, 0);
-    if (ptr == MAP_FAILED) {
-        auto err = errno;
-        auto msg = std::format("mmap({}, {}) has failed: {} - {}", pr.pointer(), pr.size_bytes(), err, strerror(err));
-        log::critical{}(msg);
-        throw std::system_error{{err, std::system_category()}, msg};
-    }
+    auto ptr = mmap(pr.pointer(), pr.size_bytes(), prot, flags | (populate ? MAP_POPULATE : 0), -1, 0);
+    if (ptr == MAP_FAILED)
+        report_system_error("mmap", pr);
     return { static_cast<std::uint64_t*>(ptr), pr.size_bytes() / sizeof(std::uint64_t) };
 }
 
-inline void mmio::allocate(pagerange requested, const stub& owner) {
-    validate(requested, owner);
-    auto page = map_range(requested);
-    allocations_.emplace(requested.begin(), allocation{requested, owner.identity(), owner.location()});
-    if (fill_.has_value()) {
+inline void map_file_range(pagerange pr, int fd, off_t offset, bool populate = false) {
+    static constexpr int prot = PROT_READ | PROT_WRITE;
+    static constexpr int flags =  MAP_PRIVATE | MAP_FIXED;
+    if (mmap(pr.pointer(), pr.size_bytes(), prot, flags | (populate ? MAP_POPULATE : 0), fd, offset) == MAP_FAILED)
+        report_system_error("mmap", pr);
+}
+
+inline void mmio::allocate(pagerange requested, const stub& owner, const byteset& bytes) {
+    const auto span = bytes_of(requested);
+    const auto claimed = bytes.within(span);
+    validate(requested, owner, claimed);
+    const auto identity = owner.identity();
+    // pages shared with other owners keep their mapping and content, the pages between them are mapped anew
+    std::vector<pagerange> unshared {};
+    auto first = requested.begin();
+    for(auto& [page, previous] : allocations_.intersecting(requested)) {
+        if (std::ranges::all_of(previous.owners, [identity](const share& i) noexcept { return i.owner == identity; }))
+            continue;
+        if (first < previous.range.begin()) unshared.push_back(pages_of(first, previous.range.begin()));
+        first = previous.range.end();
+        const auto shared = bytes_of(previous.range);
+        const byterange window { std::max(shared.first, span.first), std::min(shared.last, span.last) };
+        const auto found = std::ranges::find(previous.owners, identity, &share::owner);
+        if (found != previous.owners.end())
+            found->bytes.assign(window, claimed);
+        else
+            previous.owners.push_back({identity, owner.location(), claimed.within(window)});
+    }
+    if (first < requested.end()) unshared.push_back(pages_of(first, requested.end()));
+    for(const auto& pages : unshared) map(pages, owner, claimed);
+}
+
+inline void mmio::map(pagerange requested, const stub& owner, const byteset& bytes) {
+    // pages of the same owner, previously allocated within requested, are absorbed in one allocation
+    auto absorbed = allocations_.intersecting(requested);
+    const bool imaged = std::ranges::any_of(absorbed, [](const auto& i) noexcept { return i.second.imaged; });
+    // reserved pages mapped from a snapshot image need a fresh anonymous mapping
+    const bool protecting = reserved() && ! imaged;
+    const bool prefaulting = large(requested);
+    // huge pages are advised before the pages are populated
+    const bool populating = prefaulting && ! protecting && ! policy_.hugepages && policy_.prefault == arena::prefault_type::populate;
+    const auto start = std::chrono::steady_clock::now();
+    // pages of the template are populated for read, populating them for write would copy them
+    const bool templated = fill_.has_value() && fill_type_ == page_fill_type::mapped
+        && fill_template_.map(requested, *fill_, prefaulting && policy_.prefault != arena::prefault_type::none);
+    std::span<std::uint64_t> page {};
+    if (! templated) {
+        page = protecting ? protect_range(requested) : map_range(requested, populating);
+        if (prefaulting) prefault(requested, populating);
+    }
+    const auto elapsed = since(start);
+    count(metrics_.map, elapsed);
+    const auto& location = owner.location();
+    auto& site = sites_.try_emplace({location.file_name(), location.line()}, location).first->second;
+    count(site.map, elapsed);
+    ++mappings_;
+    auto joined = requested;
+    std::size_t absorbed_bytes {};
+    byteset owned {};
+    for(const auto& i : absorbed) {
+        joined.join(i.second.range);
+        absorbed_bytes += i.second.range.size_bytes();
+        owned.merge(i.second.owners.front().bytes);
+    }
+    owned.assign(bytes_of(requested), bytes);
+    allocations_.erase(absorbed);
+    allocations_.insert(allocation{joined, {{owner.identity(), owner.location(), std::move(owned)}}, mappings_, imaged || templated});
+    metrics_.mapped_bytes += joined.size_bytes() - absorbed_bytes;
+    metrics_.peak_mapped_bytes = std::max(metrics_.peak_mapped_bytes, metrics_.mapped_bytes);
+    if (fill_.has_value() && ! templated) {
+        const auto filling = std::chrono::steady_clock::now();
         std::fill(page.begin(), page.end(), *fill_);
+        count(metrics_.fill, since(filling));
+    }
+}
+
+inline void fill_template::close() noexcept {
+    // mappings of the template keep its file
+    if (fd_ >= 0) ::close(fd_);
+    fd_ = -1;
+    size_ = 0;
+}
+
+inline bool fill_template::prepare(std::size_t size, std::uint64_t value) noexcept {
+    if (fd_ >= 0 && value_ != value) close();
+    if (fd_ < 0) {
+        fd_ = memfd_create("stubmmio-fill", MFD_CLOEXEC);
+        if (fd_ < 0) return false;
+        value_ = value;
     }
+    if (size <= size_) return true;
+    if (ftruncate(fd_, static_cast<off_t>(size)) != 0) return false;
+    auto ptr = mmap(nullptr, size - size_, PROT_READ | PROT_WRITE, MAP_SHARED, fd_, static_cast<off_t>(size_));
+    if (ptr == MAP_FAILED) return false;
+    std::fill_n(static_cast<std::uint64_t*>(ptr), (size - size_) / sizeof(std::uint64_t), value);
+    munmap(ptr, size - size_);
+    size_ = size;
+    return true;
+}
+
+inline bool fill_template::map(pagerange pr, std::uint64_t value, bool populate) {
+    if (failed_) return false;
+    if (! prepare(std::min(pr.size_bytes(), max_size), value)) {
+        failed_ = true;
+        log_system_error("fill template", pr);
+        close();
+        return false;
+    }
+    const auto begin = static_cast<const std::byte*>(pr.pointer());
+    for(std::size_t offset = 0; offset < pr.size_bytes(); offset += max_size) {
+        const auto size = std::min(max_size, pr.size_bytes() - offset);
+        map_file_range({begin + offset, begin + offset + size}, fd_, 0, populate);
+    }
+    return true;
+}
+
+inline bool mmio::large(pagerange requested) const noexcept {
+    return (policy_.prefault != arena::prefault_type::none || policy_.hugepages) && requested.size_bytes() >= policy_.threshold;
+}
+
+inline void mmio::prefault(pagerange requested, bool populated) const noexcept {
+    // the policy is an optimization, pages fault on access if it fails
+    if (policy_.hugepages && madvise(requested.pointer(), requested.size_bytes(), MADV_HUGEPAGE) != 0)
+        log_system_error("madvise(MADV_HUGEPAGE)", requested);
+    if (policy_.prefault != arena::prefault_type::none && ! populated
+        && madvise(requested.pointer(), requested.size_bytes(), populate_write) != 0)
+        log_system_error("madvise(MADV_POPULATE_WRITE)", requested);
 }
 
 inline void mmio::deallocate(const stub& owner) {
     const auto identity = owner.identity();
-    std::erase_if(allocations_, [this, identity](const auto& i) -> bool {
-       if(i.second.owner == identity) {
-           notify(i.second.range, i.second.location);
-           unmap_range(i.second.range);
-           return true;
-       } else {
-           return false;
-       }
-    });
+    for(auto i = allocations_.begin(); i != allocations_.end();) {
+        auto& owners = i->second.owners;
+        const auto found = std::ranges::find(owners, identity, &share::owner);
+        if(found == owners.end()) {
+            ++i;
+            continue;
+        }
+        const auto location = found->location;
+        owners.erase(found);
+        // bytes of the owner keep their values until the last owner deallocates the pages
+        if(! owners.empty()) {
+            ++i;
+            continue;
+        }
+        notify(i->second.range, location);
+        const auto start = std::chrono::steady_clock::now();
+        unmap(i->second);
+        count(metrics_.unmap, since(start));
+        metrics_.mapped_bytes -= i->second.range.size_bytes();
+        i = allocations_.erase(i);
+    }
 }
 
 inline void mmio::claim(const stub& looser, const stub& claimer) {
     const auto looserid = looser.identity();
     const auto claimerid = claimer.identity();
     for(auto& i : allocations_) {
-        if(i.second.owner == looserid) {
-            i.second.owner = claimerid;
+        auto& owners = i.second.owners;
+        const auto lost = std::ranges::find(owners, looserid, &share::owner);
+        if(lost == owners.end()) continue;
+        const auto found = std::ranges::find(owners, claimerid, &share::owner);
+        if(found == owners.end()) {
+            lost->owner = claimerid;
+        } else {
+            found->bytes.merge(lost->bytes);
+            owners.erase(lost);
         }
     }
 }
@@ -185,17 +536,48 @@ inline std::size_t mmio::allocation_size() const {
 }
 
 inline bool mmio::contains(pagerange requested) const {
-    if(allocations_.contains(requested.begin())) {
-        const auto& found = allocations_.at(requested.begin());
-        return found.range.contains(requested);
-    } else {
-        auto found = std::find_if(allocations_.begin(), allocations_.end(), [requested](const auto& item) {
-            return requested.overlapping(item.second.range);
-        });
-        if (found == allocations_.end())
-            return false;
-        return found->second.range.contains(requested);
+    return allocations_.covers(requested);
+}
+
+inline std::vector<mmio::mapping> mmio::mappings() const {
+    std::vector<mapping> result {};
+    result.reserve(allocations_.size());
+    for(const auto& i : allocations_) {
+        result.push_back({i.second.range, i.second.serial});
     }
+    return result;
+}
+
+inline bool mmio::mapped(const mapping& requested) const {
+    const auto found = allocations_.find(requested.range.begin());
+    return found != allocations_.end() && found->second.range == requested.range && found->second.serial == requested.serial;
+}
+
+inline void mmio::remap(const mapping& requested, int fd, off_t offset) {
+    if (! mapped(requested)) {
+        throw exceptions::page_is_not_allocated{std::format("page range {}[{}] is not allocated",
+            requested.range.pointer(), requested.range.size_bytes())};
+    }
+    map_file_range(requested.range, fd, offset);
+    allocations_.find(requested.range.begin())->second.imaged = true;
+    // the new mapping is writable and not registered for write watching
+    clean(requested.range);
+}
+
+inline void mmio::track_writes(bool on) {
+    tracking_ = on;
+    ++tracking_epoch_;
+    for(const auto& i : allocations_) trap_writes(span_of(i.second.range), on);
+}
+
+inline void mmio::clean(pagerange pages) {
+    if (tracking_) trap_writes(span_of(pages), true);
+    restore_pages(span_of(pages));
+}
+
+inline void mmio::clean() {
+    ++tracking_epoch_;
+    for(const auto& i : allocations_) clean(i.second.range);
 }
 
 inline bool mmio::contains(volatile_span requested) const {
@@ -0,0 +1,104 @@
+/*
+ * Copyright (C) 2025 Eugene Hutorny <eugene@hutorny.in.ua>
+ *
+ * src/pageindex.h - ordered index of disjoint page ranges
+ *
+ * Licensed under MIT License, see full text in LICENSE
+ * or visit page https://opensource.org/license/mit/
+ */
+
+#pragma once
+#include <concepts>
+#include <iterator>
+#include <map>
+#include <ranges>
+#include "pagerange.h"
+
+namespace stubmmio::detail {
+
+template<typename Value>
+concept paged = requires(const Value& value) {
+    { value.range } -> std::convertible_to<pagerange>;
+};
+
+/// index of disjoint page ranges, keyed by the first page of a range
+/// all lookups are O(log n) plus number of entries found
+template<paged Value>
+class pageindex {
+public:
+    using entries_type = std::map<pageid_type, Value>;
+    using iterator = typename entries_type::iterator;
+    using const_iterator = typename entries_type::const_iterator;
+
+    auto begin() noexcept { return entries_.begin(); }
+    auto end() noexcept { return entries_.end(); }
+    auto begin() const noexcept { return entries_.begin(); }
+    auto end() const noexcept { return entries_.end(); }
+    auto size() const noexcept { return entries_.size(); }
+    auto empty() const noexcept { return entries_.empty(); }
+
+    /// inserts a value, its range is expected not to intersect with any of existing
+    auto insert(Value value) {
+        const auto key = value.range.begin();
+        return entries_.insert_or_assign(key, std::move(value)).first;
+    }
+    auto erase(const_iterator position) {
+        return entries_.erase(position);
+    }
+    auto erase(std::ranges::subrange<iterator> entries) {
+        return entries_.erase(entries.begin(), entries.end());
+    }
+    template<typename Predicate>
+    auto erase_if(Predicate predicate) {
+        return std::erase_if(entries_, predicate);
+    }
+    /// returns entry containing the page or end()
+    iterator find(pageid_type page) {
+        return find(entries_, page);
+    }
+    const_iterator find(pageid_type page) const {
+        return find(entries_, page);
+    }
+    /// returns entries intersecting with the range
+    auto intersecting(pagerange range) {
+        return intersecting(entries_, range);
+    }
+    auto intersecting(pagerange range) const {
+        return intersecting(entries_, range);
+    }
+    /// returns true if every page of the range belongs to an entry
+    bool covers(pagerange range) const {
+        auto page = range.begin();
+        do {
+            const auto found = find(page);
+            if (found == entries_.end())
+                return false;
+            page = found->second.range.end();
+        } while(page < range.end());
+        return true;
+    }
+private:
+    template<typename Entries>
+    static auto find(Entries& entries, pageid_type page) {
+        auto found = entries.upper_bound(page);
+        if (found == entries.begin())
+            return entries.end();
+        --found;
+        return page < found->second.range.end() ? found : entries.end();
+    }
+    template<typename Entries>
+    static auto intersecting(Entries& entries, pagerange range) {
+        auto first = entries.lower_bound(range.begin());
+        if (range.empty())
+            return std::ranges::subrange(first, first);
+        if (first != entries.begin()) {
+            auto previous = std::prev(first);
+            if (range.begin() < previous->second.range.end())
+                first = previous;
+        }
+        return std::ranges::subrange(first, entries.lower_bound(range.end()));
+    }
+    entries_type entries_ {};
+};
+
+} // namespace stubmmio::detail
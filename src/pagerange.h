@@ -13,7 +13,6 @@
 #include <stubmmio/types.h>
 
 namespace stubmmio::detail {
-inline constexpr std::size_t page_size = 4096;
 using pageid_type = std::uint32_t;
 
 class pagerange {
@@ -0,0 +1,194 @@
+/*
+ * Copyright (C) 2025 Eugene Hutorny <eugene@hutorny.in.ua>
+ *
+ * src/runner.cxx - parallel test runner implementation
+ *
+ * Licensed under MIT License, see full text in LICENSE
+ * or visit page https://opensource.org/license/mit/
+ */
+
+#include <stubmmio/runner.h>
+#include <stubmmio/logger.h>
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <format>
+#include <iostream>
+#include <new>
+#include <system_error>
+#include <thread>
+#include <vector>
+#include <poll.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+namespace stubmmio {
+namespace {
+using log = logovod::logger<logcategory::runner>;
+using status_type = runner::status_type;
+
+[[noreturn]] void report_system_error(std::string_view call) {
+    auto err = errno;
+    auto msg = std::format("{} has failed: {} - {}", call, err, strerror(err));
+    log::critical{}(msg);
+    throw std::system_error{{err, std::system_category()}, msg};
+}
+
+/// queue of test cases, shared among worker processes
+class shared_queue {
+public:
+    using index_type = std::atomic<std::size_t>;
+    using status_atomic = std::atomic<status_type>;
+    static_assert(index_type::is_always_lock_free && status_atomic::is_always_lock_free,
+                  "atomics shared among processes must be lock free");
+    shared_queue(std::size_t size, std::size_t workers)
+      : size_ { size }, workers_ { workers },
+        bytes_ { sizeof(index_type) * (1 + workers) + sizeof(status_atomic) * size },
+        memory_ { mmap(nullptr, bytes_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0) } {
+        if (memory_ == MAP_FAILED)
+            report_system_error("mmap");
+        new (indices()) index_type { 0 };
+        for(std::size_t i = 1; i <= workers_; ++i) new (indices() + i) index_type { size_ };
+        for(std::size_t i = 0; i < size_; ++i) new (statuses() + i) status_atomic { status_type::pending };
+    }
+    shared_queue(const shared_queue&) = delete;
+    shared_queue(shared_queue&&) = delete;
+    shared_queue& operator=(const shared_queue&) = delete;
+    shared_queue& operator=(shared_queue&&) = delete;
+    ~shared_queue() { munmap(memory_, bytes_); }
+    /// takes next test case for the worker, returns size() when the queue is exhausted
+    std::size_t take(std::size_t worker) noexcept {
+        const auto index = std::min(indices()[0].fetch_add(1), size_);
+        current(worker).store(index);
+        if (index < size_) status(index).store(status_type::running);
+        return index;
+    }
+    bool exhausted() noexcept { return indices()[0].load() >= size_; }
+    /// index of the test case, currently run by the worker
+    index_type& current(std::size_t worker) noexcept { return indices()[1 + worker]; }
+    status_atomic& status(std::size_t index) noexcept { return statuses()[index]; }
+    auto size() const noexcept { return size_; }
+private:
+    index_type* indices() noexcept { return static_cast<index_type*>(memory_); }
+    status_atomic* statuses() noexcept { return reinterpret_cast<status_atomic*>(indices() + 1 + workers_); }
+    std::size_t size_;
+    std::size_t workers_;
+    std::size_t bytes_;
+    void* memory_;
+};
+
+/// opens pidfd of the process, the syscall is used as glibc 2.36 declares pidfd_open without C linkage
+int pidfd_open(pid_t pid) noexcept {
+    return static_cast<int>(syscall(SYS_pidfd_open, pid, 0U));
+}
+
+void flush_all() {
+    std::cout.flush();
+    std::clog.flush();
+    std::fflush(nullptr);
+}
+
+} // namespace
+
+runner::runner(unsigned workers, std::source_location location)
+  : workers_ { workers != 0 ? workers : std::max(1U, std::thread::hardware_concurrency()) }, location_ { location } {}
+
+runner& runner::add(std::string_view name, case_type function) {
+    cases_.push_back({std::string{name}, std::move(function)});
+    return *this;
+}
+
+runner::result_type runner::run() const {
+    const auto workers = std::min<std::size_t>(workers_, cases_.size());
+    shared_queue queue { cases_.size(), workers };
+    auto work = [this, &queue](std::size_t worker) noexcept {
+        for(auto index = queue.take(worker); index < queue.size(); index = queue.take(worker)) {
+            const auto& test = cases_[index];
+            auto status = status_type::failed;
+            try {
+                status = test.function() ? status_type::passed : status_type::failed;
+            } catch(const std::exception& error) {
+                log::error{}.format("Test case '{}' has thrown exception:\n{}", test.name, error.what());
+            } catch(...) {
+                log::error{}.format("Test case '{}' has thrown unknown exception", test.name);
+            }
+            queue.status(index).store(status);
+        }
+        flush_all();
+        _exit(0); // skips destruction of the state, inherited from the parent
+    };
+    // workers are waited through their pidfds, so children of the process, not spawned by the runner, are left alone
+    struct child {
+        pid_t pid;
+        int pidfd;
+        std::size_t worker;
+    };
+    std::vector<child> alive {};
+    auto spawn = [&work, &alive](std::size_t worker) {
+        const auto pid = fork();
+        if (pid < 0)
+            report_system_error("fork");
+        if (pid == 0)
+            work(worker);
+        const auto pidfd = pidfd_open(pid);
+        if (pidfd < 0)
+            report_system_error("pidfd_open");
+        alive.push_back({pid, pidfd, worker});
+    };
+    auto reap = [this, &queue, &spawn](child worker) {
+        int wstatus = 0;
+        while(waitpid(worker.pid, &wstatus, 0) < 0) {
+            if (errno != EINTR)
+                report_system_error("waitpid");
+        }
+        close(worker.pidfd);
+        if (WIFEXITED(wstatus) && WEXITSTATUS(wstatus) == 0)
+            return;
+        // worker has died while running a test case, the case is crashed and the worker is replaced
+        if (const auto index = queue.current(worker.worker).load(); index < queue.size()) {
+            queue.status(index).store(status_type::crashed);
+            log::error{}.format("Test case '{}' has crashed in runner declared at {}:{}, {} {}",
+                cases_[index].name, location_.file_name(), location_.line(),
+                WIFSIGNALED(wstatus) ? "signal" : "exit status", WIFSIGNALED(wstatus) ? WTERMSIG(wstatus) : WEXITSTATUS(wstatus));
+        }
+        if (! queue.exhausted())
+            spawn(worker.worker);
+    };
+    flush_all();
+    for(std::size_t worker = 0; worker < workers; ++worker) spawn(worker);
+    std::vector<pollfd> fds {};
+    while(! alive.empty()) {
+        fds.clear();
+        for(const auto& worker : alive) fds.push_back({worker.pidfd, POLLIN, 0});
+        if (poll(fds.data(), fds.size(), -1) < 0) {
+            if (errno == EINTR) continue;
+            report_system_error("poll");
+        }
+        std::vector<child> exited {};
+        std::vector<child> running {};
+        for(std::size_t i = 0; i < fds.size(); ++i) (fds[i].revents != 0 ? exited : running).push_back(alive[i]);
+        alive = std::move(running);
+        for(const auto& worker : exited) reap(worker);
+    }
+    result_type result {};
+    result.statuses.reserve(cases_.size());
+    for(std::size_t index = 0; index < cases_.size(); ++index) {
+        const auto status = queue.status(index).load();
+        result.statuses.push_back(status);
+        switch(status) {
+        case status_type::passed: ++result.passed; break;
+        case status_type::failed: ++result.failed; break;
+        case status_type::pending:
+        case status_type::running:
+        case status_type::crashed:
+        default: ++result.crashed; break;
+        }
+    }
+    return result;
+}
+
+} // namespace stubmmio
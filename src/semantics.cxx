@@ -0,0 +1,56 @@
+/*
+ * Copyright (C) 2025 Eugene Hutorny <eugene@hutorny.in.ua>
+ *
+ * src/semantics.cxx - register access semantics
+ *
+ * Licensed under MIT License, see full text in LICENSE
+ * or visit page https://opensource.org/license/mit/
+ */
+
+#include <stubmmio/semantics.h>
+#include <format>
+#include "mmio.h"
+#include "trap.h"
+
+namespace stubmmio {
+namespace {
+
+void ensure_allocated(std::uintptr_t address, std::size_t size, std::source_location location) {
+    const detail::volatile_span addresses { reinterpret_cast<const volatile char*>(address), size };
+    if (! detail::mmio::arena().contains(addresses)) {
+        throw exceptions::page_is_not_allocated{std::format(
+            "page is not allocated for register {:X} with semantics declared at {}:{}",
+            address, location.file_name(), location.line())};
+    }
+}
+
+} // namespace
+
+semantics::semantics(initializer_list elements, std::source_location location)
+  : elements_ { elements }, location_ { location } {
+    if (! supported()) return;
+    for(const auto& item : elements_) {
+        const auto& entry = item.rule();
+        ensure_allocated(entry.address, entry.size, item.location());
+        if (entry.alias != alias_type::none) ensure_allocated(entry.target, entry.size, item.location());
+    }
+    std::size_t attached = 0;
+    try {
+        for(; attached < elements_.size(); ++attached) detail::govern_accesses(elements_[attached].rule(), this, true);
+    } catch(...) {
+        while(attached-- > 0) detail::govern_accesses(elements_[attached].rule(), this, false);
+        throw;
+    }
+    active_ = true;
+}
+
+semantics::~semantics() {
+    if (! active_) return;
+    for(const auto& item : elements_) detail::govern_accesses(item.rule(), this, false);
+}
+
+bool semantics::supported() noexcept {
+    return detail::traps_supported();
+}
+
+} // namespace stubmmio
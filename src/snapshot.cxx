@@ -0,0 +1,135 @@
+/*
+ * Copyright (C) 2025 Eugene Hutorny <eugene@hutorny.in.ua>
+ *
+ * src/snapshot.cxx - arena snapshot implementation
+ *
+ * Licensed under MIT License, see full text in LICENSE
+ * or visit page https://opensource.org/license/mit/
+ */
+
+#include <stubmmio/stubmmio.h>
+#include <stubmmio/snapshot.h>
+#include <stubmmio/logger.h>
+#include <format>
+#include <system_error>
+#include <utility>
+#include <sys/mman.h>
+#include <unistd.h>
+#include "mmio.h"
+
+namespace stubmmio {
+namespace {
+using log = logovod::logger<logcategory::arena>;
+
+[[noreturn]] void report_system_error(std::string_view what, std::source_location location) {
+    auto err = errno;
+    auto msg = std::format("{} has failed for snapshot declared at {}:{}: {} - {}",
+            what, location.file_name(), location.line(), err, strerror(err));
+    log::critical{}(msg);
+    throw std::system_error{{err, std::system_category()}, msg};
+}
+
+void write_image(int fd, const detail::pagerange& range, off_t offset, std::source_location location) {
+    const auto data = static_cast<const char*>(range.pointer());
+    std::size_t written = 0;
+    while(written < range.size_bytes()) {
+        const auto result = pwrite(fd, data + written, range.size_bytes() - written, offset + static_cast<off_t>(written));
+        if (result < 0) {
+            if (errno == EINTR) continue;
+            report_system_error("pwrite", location);
+        }
+        written += static_cast<std::size_t>(result);
+    }
+}
+
+detail::pagerange make_pagerange(std::uintptr_t address, std::size_t size) {
+    return { reinterpret_cast<const void*>(address), reinterpret_cast<const void*>(address + size) };
+}
+
+} // namespace
+
+snapshot::snapshot(std::source_location location) : location_ { location } {
+    auto& arena = detail::mmio::arena();
+    const auto mappings = arena.mappings();
+    std::size_t total = 0;
+    for(const auto& i : mappings) total += i.range.size_bytes();
+    fd_ = memfd_create("stubmmio-snapshot", MFD_CLOEXEC);
+    if (fd_ < 0)
+        report_system_error("memfd_create", location_);
+    // the destructor does not run if the constructor throws
+    try {
+        if (ftruncate(fd_, static_cast<off_t>(total)) != 0)
+            report_system_error("ftruncate", location_);
+        ranges_.reserve(mappings.size());
+        off_t offset = 0;
+        for(const auto& i : mappings) {
+            // traced and governed pages may be inaccessible, they are protected again after remap
+            if (mprotect(i.range.pointer(), i.range.size_bytes(), PROT_READ | PROT_WRITE) != 0)
+                report_system_error("mprotect", location_);
+            try {
+                write_image(fd_, i.range, offset, location_);
+            } catch(...) {
+                arena.clean(i.range);
+                throw;
+            }
+            arena.remap(i, fd_, offset);
+            ranges_.push_back({reinterpret_cast<std::uintptr_t>(i.range.pointer()), i.range.size_bytes(), i.serial});
+            offset += static_cast<off_t>(i.range.size_bytes());
+        }
+    } catch(...) {
+        close(fd_);
+        throw;
+    }
+    epoch_ = arena.tracking_epoch();
+}
+
+snapshot::snapshot(snapshot&& that) noexcept
+  : ranges_ { std::move(that.ranges_) }, fd_ { std::exchange(that.fd_, -1) }, location_ { that.location_ },
+    epoch_ { that.epoch_ } {}
+
+snapshot& snapshot::operator=(snapshot&& that) noexcept {
+    std::swap(ranges_, that.ranges_);
+    std::swap(fd_, that.fd_);
+    std::swap(location_, that.location_);
+    std::swap(epoch_, that.epoch_);
+    return *this;
+}
+
+snapshot::~snapshot() {
+    // mappings keep the image alive until the pages are deallocated
+    if (fd_ >= 0) close(fd_);
+}
+
+void snapshot::restore() const {
+    auto& arena = detail::mmio::arena();
+    // pages not written since the epoch are equal to the image
+    const bool scoped = arena.tracking_writes() && epoch_ == arena.tracking_epoch();
+    for(const auto& i : ranges_) {
+        const auto range = make_pagerange(i.address, i.size);
+        if (! arena.mapped({range, i.serial})) {
+            throw exceptions::snapshot_is_stale{std::format(
+                "page range {}[{}] captured by snapshot declared at {}:{} is no longer allocated",
+                range.pointer(), range.size_bytes(), location_.file_name(), location_.line())};
+        }
+        // dropping private copies of the pages makes them read again from the image
+        if (! scoped) {
+            if (madvise(range.pointer(), range.size_bytes(), MADV_DONTNEED) != 0)
+                report_system_error("madvise", location_);
+        } else {
+            for(const auto& written : detail::written_pages({ i.address, i.size })) {
+                if (madvise(written.begin(), written.size(), MADV_DONTNEED) != 0)
+                    report_system_error("madvise", location_);
+            }
+        }
+        arena.clean(range);
+    }
+    epoch_ = arena.tracking_epoch();
+}
+
+std::size_t snapshot::size_bytes() const noexcept {
+    std::size_t result = 0;
+    for(const auto& i : ranges_) result += i.size;
+    return result;
+}
+
+} // namespace stubmmio
@@ -10,23 +10,1147 @@
 #include <stubmmio/stubmmio.h>
 #include <stubmmio/stimulus.h>
 #include <stubmmio/logger.h>
+#include <stubmmio/semantics.h>
+#include <stubmmio/trace.h>
 
 #include "mmio.h"
+#include "trap.h"
+#include "timerwheel.h"
 
 #include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <cerrno>
+#include <chrono>
+#include <cmath>
 #include <condition_variable>
+#include <cstring>
 #include <iostream>
 #include <format>
+#include <map>
+#include <memory>
 #include <mutex>
+#include <numeric>
+#include <optional>
+#include <ranges>
+#include <system_error>
 #include <thread>
+#include <unordered_map>
+#include <fcntl.h>
+#include <linux/futex.h>
+#include <linux/userfaultfd.h>
+#include <poll.h>
+#include <pthread.h>
+#include <signal.h>
+#include <sys/eventfd.h>
+#include <sys/ioctl.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <ucontext.h>
+#include <unistd.h>
 #include <vector>
 
 namespace stubmmio {
 
+static bool contains(detail::volatile_span range, detail::volatile_span addresses);
+
+/// returns the steady time in nanoseconds
+static std::uint64_t steady_time() noexcept {
+    return static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+/// counters - statistics of stimuli, updated with relaxed atomics.
+/// Each polling worker updates its own counters, other threads update the shared ones
+struct counters {
+    using histogram_type = istimulus::stats_type::histogram_type;
+    std::atomic<std::uint64_t> polls {};
+    std::atomic<std::uint64_t> evaluations {};
+    std::atomic<std::uint64_t> actions {};
+    std::atomic<std::uint64_t> removed {};
+    std::atomic<std::uint64_t> requests {};
+    std::array<std::atomic<std::uint64_t>, std::tuple_size_v<histogram_type>> latency {};
+    static void add(std::atomic<std::uint64_t>& counter, std::uint64_t value = 1) noexcept {
+        counter.fetch_add(value, std::memory_order_relaxed);
+    }
+    /// counts an action, completed in the given nanoseconds since its condition was met
+    void acted(std::uint64_t nanoseconds) noexcept {
+        add(actions);
+        const auto bucket = std::max<std::size_t>(static_cast<std::size_t>(std::bit_width(nanoseconds)), 1) - 1;
+        add(latency[std::min(bucket, latency.size() - 1)]);
+    }
+    /// adds these counters to the statistics
+    void collect(istimulus::stats_type& stats) const noexcept {
+        stats.polls += polls.load(std::memory_order_relaxed);
+        stats.evaluations += evaluations.load(std::memory_order_relaxed);
+        stats.actions += actions.load(std::memory_order_relaxed);
+        stats.removed += removed.load(std::memory_order_relaxed);
+        stats.requests += std::chrono::nanoseconds { requests.load(std::memory_order_relaxed) };
+        for(std::size_t i = 0; i < latency.size(); ++i) stats.latency[i] += latency[i].load(std::memory_order_relaxed);
+    }
+    /// adds counters of a retired worker to these ones
+    void merge(const counters& that) noexcept {
+        add(polls, that.polls.load(std::memory_order_relaxed));
+        add(evaluations, that.evaluations.load(std::memory_order_relaxed));
+        add(actions, that.actions.load(std::memory_order_relaxed));
+        add(removed, that.removed.load(std::memory_order_relaxed));
+        add(requests, that.requests.load(std::memory_order_relaxed));
+        for(std::size_t i = 0; i < latency.size(); ++i) add(latency[i], that.latency[i].load(std::memory_order_relaxed));
+    }
+    void reset() noexcept {
+        for(auto counter : { &polls, &evaluations, &actions, &removed, &requests }) counter->store(0, std::memory_order_relaxed);
+        for(auto& counter : latency) counter.store(0, std::memory_order_relaxed);
+    }
+    /// counters of this thread
+    static counters& local() noexcept;
+    /// counters of the polling worker, running on this thread
+    static inline thread_local counters* worker_ {};
+};
+
+static constinit counters shared_counters {};
+
+counters& counters::local() noexcept {
+    return worker_ != nullptr ? *worker_ : shared_counters;
+}
+
+/// trapper - runs stimuli on the thread, writing to their watched pages, which are write protected.
+/// The faulting write is completed in single step mode, and the stimuli run on the following trap.
+/// Traced pages are not accessible, each access to them is completed in single step mode and recorded.
+/// Tracked pages are write protected until written, then the write is restarted on the writable page.
+/// Accesses to registers with semantics are completed in single step mode, and the semantics are enforced after them.
+class trapper {
+public:
+#if defined(__x86_64__) && defined(__linux__)
+    static constexpr bool supported = true;
+#else
+    static constexpr bool supported = false;
+#endif
+    static trapper& instance() {
+        static trapper inst {};
+        return inst;
+    }
+    /// returns false if the stimulus cannot be trapped and has to be polled
+    bool activate(istimulus&);
+    bool deactivate(istimulus&);
+    void unmapping(detail::volatile_span, std::source_location);
+    std::size_t count() {
+        std::lock_guard lock { mutex_ };
+        return stimuli_.size();
+    }
+    /// starts or stops tracing accesses to the pages
+    bool trace_pages(detail::volatile_span, bool on);
+    /// starts tracking writes to the pages or marks them not written, or stops tracking them
+    void track_pages(detail::volatile_span, bool on);
+    /// returns ranges of tracked pages within [first, last), written since tracked
+    std::vector<region> written(std::uintptr_t first, std::uintptr_t last);
+    /// returns true if any page within [first, last) is written or is not tracked
+    bool touched(std::uintptr_t first, std::uintptr_t last);
+    /// starts or stops enforcing semantics of the register, on behalf of the owner
+    bool govern(const semantics::rule&, const void* owner, bool on);
+    /// forgets traced, tracked and governed pages being deallocated
+    void release(detail::volatile_span) noexcept;
+    /// protects the pages mapped anew as they were protected before
+    void restore(detail::volatile_span) noexcept;
+    /// handles access fault, returns false if the fault is not on a trapped, traced, tracked, or governed page
+    bool fault(siginfo_t*, void* context) noexcept;
+    static inline trapper* active_ {};
+private:
+    struct trapped {
+        istimulus* stimulus;
+        std::uintptr_t first; ///< first watched page
+        std::uintptr_t last;  ///< page after the last watched one
+    };
+    /// access being completed in single step mode
+    struct access {
+        std::uintptr_t address;
+        trace::kind_type kind;
+        bool traced;
+        bool governed;              ///< the access is subject to the rule
+        semantics::rule rule;
+        std::uint64_t before;       ///< value of the governed register before the access
+    };
+    /// register with semantics, keyed by each of its bytes
+    struct governed {
+        semantics::rule rule;
+        const void* owner;
+    };
+    /// page with governed registers
+    struct governed_page {
+        unsigned rules;
+        unsigned reads;             ///< rules, which need reads trapped
+    };
+    trapper();
+    ~trapper();
+    trapper(const trapper&) = delete;
+    trapper(trapper&&) = delete;
+    trapper& operator=(const trapper&) = delete;
+    trapper& operator=(trapper&&) = delete;
+    static void on_sigsegv(int, siginfo_t*, void*);
+    static void on_sigtrap(int, siginfo_t*, void*);
+    static void chain(const struct sigaction&, int, siginfo_t*, void*);
+    static void trap_flag(void* context, bool set) noexcept;
+    static trace::kind_type access_kind(void* context) noexcept;
+    static void record(const access&) noexcept;
+    static bool applies(const semantics::rule&, trace::kind_type) noexcept;
+    static std::uint64_t load(std::uintptr_t address, std::size_t size) noexcept;
+    static void store(std::uintptr_t address, std::size_t size, std::uint64_t value) noexcept;
+    /// enforces semantics on the completed access, returns address of the register, modified by it
+    std::uintptr_t enforce() noexcept;
+    void step(std::uintptr_t page) noexcept;
+    void unwatch(const trapped&, bool restore) noexcept;
+    /// returns protection of the page, while it is trapped or traced
+    int protection(std::uintptr_t page) const noexcept;
+    void protect_all(bool armed) noexcept;
+    /// makes trapped and traced pages writable, counting them as written if tracked
+    void open_all() noexcept;
+    std::recursive_mutex mutex_ {};
+    std::vector<trapped> stimuli_ {};
+    std::map<std::uintptr_t, unsigned> pages_ {};
+    std::map<std::uintptr_t, unsigned> traced_ {};
+    std::map<std::uintptr_t, bool> tracked_ {}; ///< tracked pages, true if written
+    std::unordered_map<std::uintptr_t, governed> governed_ {};
+    std::unordered_map<std::uintptr_t, governed_page> governed_pages_ {};
+    struct sigaction previous_segv_ {};
+    struct sigaction previous_trap_ {};
+    static thread_local inline std::uintptr_t stepping_ {};
+    static thread_local inline access pending_ {};
+    using log = logovod::logger<logcategory::stimulus>;
+};
+
+trapper::trapper() {
+    struct sigaction act {};
+    act.sa_flags = SA_SIGINFO;
+    sigemptyset(&act.sa_mask);
+    act.sa_sigaction = &on_sigsegv;
+    if (sigaction(SIGSEGV, &act, &previous_segv_) != 0)
+        log::critical{}.format("sigaction error {}: {}", errno, strerror(errno));
+    act.sa_sigaction = &on_sigtrap;
+    if (sigaction(SIGTRAP, &act, &previous_trap_) != 0)
+        log::critical{}.format("sigaction error {}: {}", errno, strerror(errno));
+    active_ = this;
+}
+
+trapper::~trapper() {
+    active_ = nullptr;
+    protect_all(false);
+    sigaction(SIGSEGV, &previous_segv_, nullptr);
+    sigaction(SIGTRAP, &previous_trap_, nullptr);
+}
+
+bool trapper::activate(istimulus& stimul) {
+    const auto watch = stimul.spans_.front();
+    const auto begin = reinterpret_cast<std::uintptr_t>(watch.data());
+    // pages outside the arena may be stack or data of the test itself, they are not protected
+    if (begin + watch.size() > arena::size())
+        return false;
+    std::lock_guard lock { mutex_ };
+    if (std::ranges::find(stimuli_, &stimul, &trapped::stimulus) != stimuli_.end())
+        return true;
+    stimul.active();
+    // the condition may be already satisfied
+    if (stimul.running() == istimulus::status_type::done)
+        return true;
+    const trapped entry { &stimul, begin / detail::page_size * detail::page_size,
+        (begin + watch.size() + detail::page_size - 1) / detail::page_size * detail::page_size };
+    for(auto page = entry.first; page < entry.last; page += detail::page_size) {
+        if (pages_[page]++ == 0 && mprotect(reinterpret_cast<void*>(page), detail::page_size, protection(page)) != 0) {
+            const auto error = errno;
+            unwatch({ &stimul, entry.first, page + detail::page_size }, true);
+            auto message = std::format("mprotect has failed: {} - {}", error, strerror(error));
+            log::critical{}(message);
+            throw std::system_error{{error, std::system_category()}, message};
+        }
+    }
+    stimuli_.push_back(entry);
+    return true;
+}
+
+bool trapper::deactivate(istimulus& stimul) {
+    std::lock_guard lock { mutex_ };
+    const auto found = std::ranges::find(stimuli_, &stimul, &trapped::stimulus);
+    if (found == stimuli_.end())
+        return false;
+    unwatch(*found, true);
+    stimuli_.erase(found);
+    stimul.inactive();
+    return true;
+}
+
+void trapper::unmapping(detail::volatile_span range, std::source_location location) {
+    std::lock_guard lock { mutex_ };
+    const auto removed = std::erase_if(stimuli_, [range, location, this](const trapped& entry) {
+        if (std::ranges::none_of(entry.stimulus->spans_, [range](auto sp) noexcept { return contains(range, sp); }))
+            return false;
+        unwatch(entry, false);
+        log::error{}.format("Removing stimulus because it uses stub page being deallocated\n"
+            "Stimulus defined at {}:{}:\nStub defined at {}:{}\n",
+            entry.stimulus->location_.file_name(), entry.stimulus->location_.line(), location.file_name(), location.line());
+        return true;
+    });
+    counters::add(shared_counters.removed, removed);
+}
+
+void trapper::release(detail::volatile_span range) noexcept {
+    const auto begin = reinterpret_cast<std::uintptr_t>(range.data());
+    const auto first = begin / detail::page_size * detail::page_size;
+    const auto end = begin + range.size();
+    const auto within = [first, end](const auto& item) noexcept { return first <= item.first && item.first < end; };
+    std::lock_guard lock { mutex_ };
+    traced_.erase(traced_.lower_bound(first), traced_.lower_bound(end));
+    tracked_.erase(tracked_.lower_bound(first), tracked_.lower_bound(end));
+    std::erase_if(governed_, within);
+    std::erase_if(governed_pages_, within);
+}
+
+void trapper::restore(detail::volatile_span range) noexcept {
+    const auto begin = reinterpret_cast<std::uintptr_t>(range.data());
+    const auto first = begin / detail::page_size * detail::page_size;
+    const auto end = begin + range.size();
+    std::lock_guard lock { mutex_ };
+    const auto protect = [this, first, end](const auto& pages) noexcept {
+        for(auto page = pages.lower_bound(first); page != pages.end() && page->first < end; ++page)
+            mprotect(reinterpret_cast<void*>(page->first), detail::page_size, protection(page->first));
+    };
+    protect(pages_);
+    protect(traced_);
+    protect(tracked_);
+    for(const auto& page : governed_pages_) {
+        if (first <= page.first && page.first < end)
+            mprotect(reinterpret_cast<void*>(page.first), detail::page_size, protection(page.first));
+    }
+}
+
+bool trapper::trace_pages(detail::volatile_span addresses, bool on) {
+    const auto begin = reinterpret_cast<std::uintptr_t>(addresses.data());
+    const auto first = begin / detail::page_size * detail::page_size;
+    const auto last = (begin + addresses.size() + detail::page_size - 1) / detail::page_size * detail::page_size;
+    std::lock_guard lock { mutex_ };
+    for(auto page = first; page < last; page += detail::page_size) {
+        if (! on) {
+            const auto found = traced_.find(page);
+            if (found == traced_.end() || --found->second != 0)
+                continue;
+            traced_.erase(found);
+            mprotect(reinterpret_cast<void*>(page), detail::page_size, protection(page));
+        } else if (traced_[page]++ == 0 && mprotect(reinterpret_cast<void*>(page), detail::page_size, PROT_NONE) != 0) {
+            const auto error = errno;
+            trace_pages({ addresses.data(), page + detail::page_size - begin }, false);
+            auto message = std::format("mprotect has failed: {} - {}", error, strerror(error));
+            log::critical{}(message);
+            throw std::system_error{{error, std::system_category()}, message};
+        }
+    }
+    return true;
+}
+
+void trapper::track_pages(detail::volatile_span addresses, bool on) {
+    const auto begin = reinterpret_cast<std::uintptr_t>(addresses.data());
+    const auto first = begin / detail::page_size * detail::page_size;
+    const auto last = (begin + addresses.size() + detail::page_size - 1) / detail::page_size * detail::page_size;
+    std::lock_guard lock { mutex_ };
+    for(auto page = first; page < last; page += detail::page_size) {
+        if (on)
+            tracked_.insert_or_assign(page, false);
+        else if (tracked_.erase(page) == 0)
+            continue;
+        if (mprotect(reinterpret_cast<void*>(page), detail::page_size, protection(page)) != 0) {
+            const auto error = errno;
+            auto message = std::format("mprotect has failed: {} - {}", error, strerror(error));
+            log::critical{}(message);
+            throw std::system_error{{error, std::system_category()}, message};
+        }
+    }
+}
+
+bool trapper::govern(const semantics::rule& rule, const void* owner, bool on) {
+    const auto first = rule.address / detail::page_size * detail::page_size;
+    const auto last = rule.address + rule.size;
+    const auto reads = applies(rule, trace::kind_type::read) ? 1U : 0U;
+    std::lock_guard lock { mutex_ };
+    if (! on) {
+        const auto found = governed_.find(rule.address);
+        if (found == governed_.end() || found->second.owner != owner)
+            return false;
+        for(auto address = rule.address; address < last; ++address) governed_.erase(address);
+        for(auto page = first; page < last; page += detail::page_size) {
+            const auto counts = governed_pages_.find(page);
+            if (counts == governed_pages_.end()) continue;
+            counts->second.reads -= reads;
+            if (--counts->second.rules == 0) governed_pages_.erase(counts);
+            mprotect(reinterpret_cast<void*>(page), detail::page_size, protection(page));
+        }
+        return true;
+    }
+    for(auto address = rule.address; address < last; ++address) {
+        if (governed_.contains(address))
+            throw exceptions::duplicate_address{std::format("Register at {:X} already has semantics", rule.address)};
+    }
+    for(auto address = rule.address; address < last; ++address) governed_.emplace(address, governed { rule, owner });
+    for(auto page = first; page < last; page += detail::page_size) {
+        auto& counts = governed_pages_[page];
+        ++counts.rules;
+        counts.reads += reads;
+        if (mprotect(reinterpret_cast<void*>(page), detail::page_size, protection(page)) != 0) {
+            const auto error = errno;
+            govern(rule, owner, false);
+            auto message = std::format("mprotect has failed: {} - {}", error, strerror(error));
+            log::critical{}(message);
+            throw std::system_error{{error, std::system_category()}, message};
+        }
+    }
+    return true;
+}
+
+std::vector<region> trapper::written(std::uintptr_t first, std::uintptr_t last) {
+    std::vector<region> result {};
+    std::lock_guard lock { mutex_ };
+    for(auto page = tracked_.lower_bound(first); page != tracked_.end() && page->first < last; ++page) {
+        if (! page->second) continue;
+        if (! result.empty() && result.back().addr() + result.back().size() == page->first)
+            result.back() = region { result.back().addr(), result.back().size() + detail::page_size };
+        else
+            result.push_back(region { page->first, detail::page_size });
+    }
+    return result;
+}
+
+bool trapper::touched(std::uintptr_t first, std::uintptr_t last) {
+    std::lock_guard lock { mutex_ };
+    for(auto page = first / detail::page_size * detail::page_size; page < last; page += detail::page_size) {
+        const auto found = tracked_.find(page);
+        if (found == tracked_.end() || found->second) return true;
+    }
+    return false;
+}
+
+void trapper::unwatch(const trapped& entry, bool restore) noexcept {
+    for(auto page = entry.first; page < entry.last; page += detail::page_size) {
+        const auto found = pages_.find(page);
+        if (found == pages_.end() || --found->second != 0)
+            continue;
+        pages_.erase(found);
+        if (restore) mprotect(reinterpret_cast<void*>(page), detail::page_size, protection(page));
+    }
+}
+
+int trapper::protection(std::uintptr_t page) const noexcept {
+    if (traced_.contains(page)) return PROT_NONE;
+    if (const auto found = governed_pages_.find(page); found != governed_pages_.end())
+        return found->second.reads != 0 ? PROT_NONE : PROT_READ;
+    if (pages_.contains(page)) return PROT_READ;
+    const auto tracked = tracked_.find(page);
+    return tracked != tracked_.end() && ! tracked->second ? PROT_READ : PROT_READ | PROT_WRITE;
+}
+
+void trapper::protect_all(bool armed) noexcept {
+    const auto protect = [this, armed](const auto& pages) noexcept {
+        for(const auto& page : pages) {
+            mprotect(reinterpret_cast<void*>(page.first), detail::page_size,
+                armed ? protection(page.first) : PROT_READ | PROT_WRITE);
+        }
+    };
+    protect(pages_);
+    protect(traced_);
+    protect(tracked_);
+    protect(governed_pages_);
+}
+
+void trapper::open_all() noexcept {
+    const auto open = [this](const auto& pages) noexcept {
+        for(const auto& page : pages) {
+            // writes to the open pages are not detected
+            if (const auto tracked = tracked_.find(page.first); tracked != tracked_.end())
+                tracked->second = true;
+            mprotect(reinterpret_cast<void*>(page.first), detail::page_size, PROT_READ | PROT_WRITE);
+        }
+    };
+    open(pages_);
+    open(traced_);
+    open(governed_pages_);
+}
+
+void trapper::trap_flag([[maybe_unused]] void* context, [[maybe_unused]] bool set) noexcept {
+#if defined(__x86_64__) && defined(__linux__)
+    static constexpr greg_t flag = 0x100;
+    auto& flags = static_cast<ucontext_t*>(context)->uc_mcontext.gregs[REG_EFL];
+    flags = set ? (flags | flag) : (flags & ~flag);
+#endif
+}
+
+trace::kind_type trapper::access_kind([[maybe_unused]] void* context) noexcept {
+#if defined(__x86_64__) && defined(__linux__)
+    // bit 1 of the page fault error code is set on write access
+    static constexpr greg_t write = 0x2;
+    const auto error = static_cast<ucontext_t*>(context)->uc_mcontext.gregs[REG_ERR];
+    return (error & write) != 0 ? trace::kind_type::write : trace::kind_type::read;
+#else
+    return trace::kind_type::write;
+#endif
+}
+
+void trapper::record(const access& completed) noexcept {
+    // the width of the access is not known, so the value is taken from up to 8 bytes at the address
+    const auto page_end = (completed.address / detail::page_size + 1) * detail::page_size;
+    const auto size = std::min<std::uintptr_t>(sizeof(std::uint64_t), page_end - completed.address);
+    const auto* bytes = reinterpret_cast<const volatile std::uint8_t*>(completed.address);
+    std::uint64_t value {};
+    for(std::uintptr_t i = 0; i < size; ++i)
+        value |= std::uint64_t { bytes[i] } << (i * 8);
+    trace::detail::append(bytes, 0, value, completed.kind);
+}
+
+bool trapper::applies(const semantics::rule& rule, trace::kind_type kind) noexcept {
+    if (kind == trace::kind_type::read)
+        return rule.alias == semantics::alias_type::none && rule.bits.read_to_clear != 0;
+    return rule.alias != semantics::alias_type::none || rule.bits.read_only != 0 || rule.bits.write_1_to_clear != 0;
+}
+
+std::uint64_t trapper::load(std::uintptr_t address, std::size_t size) noexcept {
+    std::uint64_t value {};
+    std::memcpy(&value, reinterpret_cast<const void*>(address), std::min(size, sizeof(value)));
+    return value;
+}
+
+void trapper::store(std::uintptr_t address, std::size_t size, std::uint64_t value) noexcept {
+    std::memcpy(reinterpret_cast<void*>(address), &value, std::min(size, sizeof(value)));
+}
+
+std::uintptr_t trapper::enforce() noexcept {
+    const auto& rule = pending_.rule;
+    const auto before = pending_.before;
+    if (pending_.kind == trace::kind_type::read) {
+        store(rule.address, rule.size, before & ~rule.bits.read_to_clear);
+        return rule.address;
+    }
+    const auto value = load(rule.address, rule.size);
+    if (rule.alias == semantics::alias_type::none) {
+        const auto w1c = rule.bits.write_1_to_clear;
+        const auto ro = rule.bits.read_only & ~w1c;
+        store(rule.address, rule.size, (value & ~(ro | w1c)) | (before & ro) | (before & w1c & ~value));
+        return rule.address;
+    }
+    store(rule.address, rule.size, before);
+    const auto page = rule.target / detail::page_size * detail::page_size;
+    // the page of the alias is open for the access, the page of the target may be protected
+    const bool closed = page != pending_.address / detail::page_size * detail::page_size;
+    if (closed) mprotect(reinterpret_cast<void*>(page), detail::page_size, PROT_READ | PROT_WRITE);
+    auto target = load(rule.target, rule.size);
+    switch(rule.alias) {
+    case semantics::alias_type::set: target |= value; break;
+    case semantics::alias_type::clear: target &= ~value; break;
+    case semantics::alias_type::toggle: target ^= value; break;
+    case semantics::alias_type::none:
+    default: break;
+    }
+    store(rule.target, rule.size, target);
+    if (closed) mprotect(reinterpret_cast<void*>(page), detail::page_size, protection(page));
+    return rule.target;
+}
+
+bool trapper::fault(siginfo_t* info, void* context) noexcept {
+    const auto address = reinterpret_cast<std::uintptr_t>(info->si_addr);
+    const auto page = address / detail::page_size * detail::page_size;
+    std::lock_guard lock { mutex_ };
+    if (stepping_ != 0)
+        return false;
+    const auto traced = traced_.contains(page);
+    const auto watched = pages_.contains(page);
+    const auto governs = governed_pages_.contains(page);
+    const auto tracked = tracked_.find(page);
+    if (! traced && ! watched && ! governs && tracked == tracked_.end())
+        return false;
+    const auto kind = access_kind(context);
+    if (tracked != tracked_.end() && kind == trace::kind_type::write)
+        tracked->second = true;
+    // a written page, which is only tracked, stays writable and the write restarts
+    if (! traced && ! watched && ! governs)
+        return mprotect(reinterpret_cast<void*>(page), detail::page_size, protection(page)) == 0;
+    if (mprotect(reinterpret_cast<void*>(page), detail::page_size, PROT_READ | PROT_WRITE) != 0)
+        return false;
+    // the faulting access completes in single step mode,
+    // then the trap records it, enforces semantics of the register and runs the stimuli
+    pending_ = { address, kind, traced, false, {}, 0 };
+    if (governs) {
+        if (const auto found = governed_.find(address); found != governed_.end() && applies(found->second.rule, kind)) {
+            pending_.governed = true;
+            pending_.rule = found->second.rule;
+            pending_.before = load(pending_.rule.address, pending_.rule.size);
+        }
+    }
+    stepping_ = page;
+    trap_flag(context, true);
+    return true;
+}
+
+void trapper::step(std::uintptr_t page) noexcept {
+    std::lock_guard lock { mutex_ };
+    if (pending_.traced) record(pending_);
+    // an alias modifies its target, which may be on another watched page
+    const auto modified = (pending_.governed ? enforce() : pending_.address) / detail::page_size * detail::page_size;
+    if (pending_.kind != trace::kind_type::write || (! pages_.contains(page) && ! pages_.contains(modified))) {
+        mprotect(reinterpret_cast<void*>(page), detail::page_size, protection(page));
+        return;
+    }
+    // actions may write to other trapped pages, so all are writable while stimuli run
+    open_all();
+    // first the stimuli watching the written page run, then all while actions trigger other stimuli
+    for(bool cascade = false, fired = true; fired; cascade = true) {
+        fired = false;
+        for(std::size_t i = 0; i < stimuli_.size();) {
+            const auto entry = stimuli_[i];
+            const auto covers = [&entry](std::uintptr_t at) noexcept { return entry.first <= at && at < entry.last; };
+            if (! cascade && ! covers(page) && ! covers(modified)) {
+                ++i;
+                continue;
+            }
+            try {
+                if (entry.stimulus->running() != istimulus::status_type::done) {
+                    ++i;
+                    continue;
+                }
+                fired = true;
+            } catch(const std::exception& error) {
+                log::error{}.format("Exception caught when running stimulus defined at {}:{}:\n{}",
+                        entry.stimulus->location_.file_name(), entry.stimulus->location_.line(), error.what());
+            }
+            unwatch(entry, false);
+            stimuli_.erase(stimuli_.begin() + static_cast<std::ptrdiff_t>(i));
+        }
+        if (stimuli_.empty()) break;
+    }
+    protect_all(true);
+}
+
+void trapper::chain(const struct sigaction& previous, int sig, siginfo_t* info, void* context) {
+    if ((previous.sa_flags & SA_SIGINFO) != 0) {
+        if (previous.sa_sigaction != nullptr) previous.sa_sigaction(sig, info, context);
+    } else if (previous.sa_handler == SIG_DFL) {
+        // the default action takes place when the signal is raised again
+        signal(sig, SIG_DFL);
+        if (sig != SIGSEGV) raise(sig);
+    } else if (previous.sa_handler != SIG_IGN) {
+        previous.sa_handler(sig);
+    }
+}
+
+void trapper::on_sigsegv(int sig, siginfo_t* info, void* context) {
+    if (active_ != nullptr && active_->fault(info, context))
+        return;
+    if (active_ != nullptr) chain(active_->previous_segv_, sig, info, context);
+}
+
+void trapper::on_sigtrap(int sig, siginfo_t* info, void* context) {
+    if (stepping_ == 0 || active_ == nullptr) {
+        if (active_ != nullptr) chain(active_->previous_trap_, sig, info, context);
+        return;
+    }
+    trap_flag(context, false);
+    active_->step(std::exchange(stepping_, 0));
+}
+
+bool detail::handle_write_fault(siginfo_t* info, void* context) noexcept {
+    return trapper::active_ != nullptr && trapper::active_->fault(info, context);
+}
+
+bool detail::traps_supported() noexcept {
+    return trapper::supported;
+}
+
+bool detail::govern_accesses(const semantics::rule& rule, const void* owner, bool on) {
+    if (! trapper::supported) return false;
+    if (! on) return trapper::active_ != nullptr && trapper::active_->govern(rule, owner, false);
+    return trapper::instance().govern(rule, owner, true);
+}
+
+bool detail::trap_accesses(volatile_span addresses, bool on) {
+    if (! trapper::supported) return false;
+    if (! on) return trapper::active_ == nullptr || trapper::active_->trace_pages(addresses, false);
+    return trapper::instance().trace_pages(addresses, true);
+}
+
+void detail::trap_writes(volatile_span addresses, bool on) {
+    if (on)
+        trapper::instance().track_pages(addresses, true);
+    else if (trapper::active_ != nullptr)
+        trapper::active_->track_pages(addresses, false);
+}
+
+std::vector<region> detail::written_pages(region within) {
+    if (trapper::active_ == nullptr) return {};
+    return trapper::active_->written(within.addr(), within.addr() + within.size());
+}
+
+bool detail::pages_written(region within) {
+    return trapper::active_ == nullptr || trapper::active_->touched(within.addr(), within.addr() + within.size());
+}
+
+void detail::release_pages(volatile_span addresses) noexcept {
+    if (trapper::active_ != nullptr) trapper::active_->release(addresses);
+}
+
+/// write_watcher - write protects watched pages with userfaultfd and runs stimuli on a handler thread.
+/// A written page stays writable for settle_time, then it is protected again
+/// and the stimuli watching it are evaluated, so that no write remains unnoticed.
+class write_watcher {
+public:
+    static constexpr auto settle_time = std::chrono::microseconds { 100 };
+    static bool supported() noexcept {
+        static const bool result = [] () noexcept {
+            const int fd = open_userfaultfd();
+            if (fd < 0) return false;
+            close(fd);
+            return true;
+        }();
+        return result;
+    }
+    static write_watcher& instance() {
+        static write_watcher inst {};
+        return inst;
+    }
+    /// returns false if the stimulus cannot be watched and has to be polled
+    bool activate(istimulus&);
+    bool deactivate(istimulus&);
+    void unmapping(detail::volatile_span, std::source_location);
+    /// registers and protects watched pages mapped anew, returns stimuli, which pages cannot be watched anymore
+    std::vector<istimulus*> remapped(detail::volatile_span);
+    std::size_t count() {
+        std::lock_guard lock { mutex_ };
+        return stimuli_.size();
+    }
+    static inline write_watcher* active_ {};
+private:
+    using clock = std::chrono::steady_clock;
+    struct watched {
+        istimulus* stimulus;
+        std::uintptr_t first;        ///< first watched page
+        std::uintptr_t last;         ///< page after the last watched one
+        std::uintptr_t modify_first; ///< first modified page
+        std::uintptr_t modify_last;  ///< page after the last modified one
+    };
+    write_watcher();
+    ~write_watcher();
+    write_watcher(const write_watcher&) = delete;
+    write_watcher(write_watcher&&) = delete;
+    write_watcher& operator=(const write_watcher&) = delete;
+    write_watcher& operator=(write_watcher&&) = delete;
+    static int open_userfaultfd() noexcept;
+    /// registers the page and protects it, unless it is open
+    bool watch(std::uintptr_t page) noexcept;
+    void run(std::stop_token) noexcept;
+    void fault(std::uintptr_t page);
+    void settle();
+    /// evaluates the stimulus, returns true if it is done
+    bool evaluate(const watched&);
+    void open(std::uintptr_t first, std::uintptr_t last);
+    bool protect(std::uintptr_t page, bool on) noexcept;
+    void unwatch(const watched&) noexcept;
+    std::mutex mutex_ {};
+    std::vector<watched> stimuli_ {};
+    std::map<std::uintptr_t, unsigned> pages_ {};
+    std::map<std::uintptr_t, clock::time_point> open_ {};
+    int uffd_;
+    int wakeup_;
+    std::jthread thread_;
+    using log = logovod::logger<logcategory::stimulus>;
+};
+
+static auto page_span(detail::volatile_span span) noexcept {
+    const auto begin = reinterpret_cast<std::uintptr_t>(span.data());
+    return std::pair { begin / detail::page_size * detail::page_size,
+        (begin + span.size() + detail::page_size - 1) / detail::page_size * detail::page_size };
+}
+
+int write_watcher::open_userfaultfd() noexcept {
+#ifdef UFFD_FEATURE_WP_HUGETLBFS_SHMEM
+    // pages remapped from a snapshot image or the fill template are shmem backed
+    static constexpr std::uint64_t shmem = UFFD_FEATURE_WP_HUGETLBFS_SHMEM;
+#else
+    static constexpr std::uint64_t shmem = 0;
+#endif
+    // the handshake may be done once per descriptor, so the one without shmem support needs another descriptor
+    for(const auto features : { UFFD_FEATURE_PAGEFAULT_FLAG_WP | shmem, std::uint64_t { UFFD_FEATURE_PAGEFAULT_FLAG_WP } }) {
+        const int fd = static_cast<int>(syscall(SYS_userfaultfd, O_CLOEXEC | O_NONBLOCK | UFFD_USER_MODE_ONLY));
+        if (fd < 0) return fd;
+        uffdio_api api { UFFD_API, features, 0 };
+        if (ioctl(fd, UFFDIO_API, &api) == 0 && (api.ioctls & (1ULL << _UFFDIO_REGISTER)) != 0)
+            return fd;
+        close(fd);
+    }
+    return -1;
+}
+
+write_watcher::write_watcher()
+  : uffd_ { open_userfaultfd() }, wakeup_ { eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK) },
+    thread_ { [this](std::stop_token stop) noexcept { run(stop); } } {
+    if (uffd_ < 0 || wakeup_ < 0)
+        log::critical{}.format("userfaultfd or eventfd error {}: {}", errno, strerror(errno));
+    active_ = this;
+}
+
+write_watcher::~write_watcher() {
+    active_ = nullptr;
+    thread_.request_stop();
+    const std::uint64_t one = 1;
+    static_cast<void>(write(wakeup_, &one, sizeof(one)));
+    thread_.join();
+    for(const auto& page : pages_) protect(page.first, false);
+    close(uffd_);
+    close(wakeup_);
+}
+
+bool write_watcher::protect(std::uintptr_t page, bool on) noexcept {
+    uffdio_writeprotect wp { { page, detail::page_size }, on ? UFFDIO_WRITEPROTECT_MODE_WP : 0 };
+    return ioctl(uffd_, UFFDIO_WRITEPROTECT, &wp) == 0;
+}
+
+bool write_watcher::activate(istimulus& stimul) {
+    const auto [first, last] = page_span(stimul.spans_.front());
+    const auto [modify_first, modify_last] = page_span(stimul.spans_.back());
+    // pages outside the arena may be stack or data of the test itself, they are not protected
+    if (uffd_ < 0 || last > arena::size())
+        return false;
+    std::lock_guard lock { mutex_ };
+    if (std::ranges::find(stimuli_, &stimul, &watched::stimulus) != stimuli_.end())
+        return true;
+    const watched entry { &stimul, first, last, modify_first, modify_last };
+    for(auto page = first; page < last; page += detail::page_size) {
+        if (pages_[page]++ != 0) continue;
+        if (! watch(page)) {
+            log::error{}.format("userfaultfd error {}: {} for stimulus defined at {}:{}, it is polled instead",
+                errno, strerror(errno), stimul.location_.file_name(), stimul.location_.line());
+            unwatch({ &stimul, first, page + detail::page_size, modify_first, modify_last });
+            return false;
+        }
+    }
+    stimul.active();
+    // the condition may be already satisfied
+    if (! evaluate(entry))
+        stimuli_.push_back(entry);
+    return true;
+}
+
+bool write_watcher::watch(std::uintptr_t page) noexcept {
+    // pages have to be populated to be write protected
+    auto& touched = *reinterpret_cast<volatile std::byte*>(page);
+    touched = touched;
+    uffdio_register reg { { page, detail::page_size }, UFFDIO_REGISTER_MODE_WP, 0 };
+    return ioctl(uffd_, UFFDIO_REGISTER, &reg) == 0 && (open_.contains(page) || protect(page, true));
+}
+
+std::vector<istimulus*> write_watcher::remapped(detail::volatile_span range) {
+    const auto [first, last] = page_span(range);
+    std::vector<istimulus*> result {};
+    std::lock_guard lock { mutex_ };
+    // the kernel drops registration of the pages replaced by the new mapping
+    std::vector<std::uintptr_t> failed {};
+    for(auto page = pages_.lower_bound(first); page != pages_.end() && page->first < last; ++page) {
+        if (watch(page->first)) continue;
+        log::error{}.format("userfaultfd error {}: {} for page {:X} mapped anew, its stimuli are polled instead",
+            errno, strerror(errno), page->first);
+        failed.push_back(page->first);
+    }
+    for(std::size_t i = 0; i < stimuli_.size();) {
+        const auto entry = stimuli_[i];
+        if (std::ranges::none_of(failed, [&entry](auto page) noexcept { return entry.first <= page && page < entry.last; })) {
+            ++i;
+            continue;
+        }
+        unwatch(entry);
+        stimuli_.erase(stimuli_.begin() + static_cast<std::ptrdiff_t>(i));
+        entry.stimulus->inactive();
+        result.push_back(entry.stimulus);
+    }
+    return result;
+}
+
+bool write_watcher::deactivate(istimulus& stimul) {
+    std::lock_guard lock { mutex_ };
+    const auto found = std::ranges::find(stimuli_, &stimul, &watched::stimulus);
+    if (found == stimuli_.end())
+        return false;
+    unwatch(*found);
+    stimuli_.erase(found);
+    stimul.inactive();
+    return true;
+}
+
+void write_watcher::unmapping(detail::volatile_span range, std::source_location location) {
+    std::lock_guard lock { mutex_ };
+    const auto [first, last] = page_span(range);
+    const auto removed = std::erase_if(stimuli_, [range, location, this](const watched& entry) {
+        if (std::ranges::none_of(entry.stimulus->spans_, [range](auto sp) noexcept { return contains(range, sp); }))
+            return false;
+        // pages of the stimulus outside of the range stay mapped
+        unwatch(entry);
+        log::error{}.format("Removing stimulus because it uses stub page being deallocated\n"
+            "Stimulus defined at {}:{}:\nStub defined at {}:{}\n",
+            entry.stimulus->location_.file_name(), entry.stimulus->location_.line(), location.file_name(), location.line());
+        return true;
+    });
+    counters::add(shared_counters.removed, removed);
+    // registration of unmapped pages is dropped by the kernel
+    std::erase_if(pages_, [first, last](const auto& page) noexcept { return first <= page.first && page.first < last; });
+    std::erase_if(open_, [first, last](const auto& page) noexcept { return first <= page.first && page.first < last; });
+}
+
+void write_watcher::unwatch(const watched& entry) noexcept {
+    for(auto page = entry.first; page < entry.last; page += detail::page_size) {
+        const auto found = pages_.find(page);
+        if (found == pages_.end() || --found->second != 0)
+            continue;
+        pages_.erase(found);
+        open_.erase(page);
+        protect(page, false);
+        uffdio_range range { page, detail::page_size };
+        ioctl(uffd_, UFFDIO_UNREGISTER, &range);
+    }
+}
+
+void write_watcher::open(std::uintptr_t first, std::uintptr_t last) {
+    const auto deadline = clock::now() + settle_time;
+    for(auto page = first; page < last; page += detail::page_size) {
+        if (! pages_.contains(page)) continue;
+        if (! open_.contains(page)) protect(page, false);
+        open_[page] = deadline;
+    }
+}
+
+bool write_watcher::evaluate(const watched& entry) {
+    auto& stimul = *entry.stimulus;
+    try {
+        stimul.status_ = istimulus::status_type::running;
+        if (! stimul.evaluate())
+            return false;
+        const auto met = steady_time();
+        // the action runs on this thread, so its pages must be writable, and they are evaluated after settle
+        open(entry.modify_first, entry.modify_last);
+        stimul.complete(met);
+        stimul.status_ = istimulus::status_type::done;
+    } catch(const std::exception& error) {
+        log::error{}.format("Exception caught when running stimulus defined at {}:{}:\n{}",
+                stimul.location_.file_name(), stimul.location_.line(), error.what());
+    }
+    unwatch(entry);
+    return true;
+}
+
+void write_watcher::fault(std::uintptr_t page) {
+    std::lock_guard lock { mutex_ };
+    if (! pages_.contains(page)) {
+        // the page is not watched anymore, the writer has to be woken up anyway
+        uffdio_range range { page, detail::page_size };
+        ioctl(uffd_, UFFDIO_WAKE, &range);
+        return;
+    }
+    if (! open_.contains(page)) protect(page, false);
+    open_[page] = clock::now() + settle_time;
+}
+
+void write_watcher::settle() {
+    std::lock_guard lock { mutex_ };
+    const auto now = clock::now();
+    std::vector<std::uintptr_t> settled {};
+    for(auto i = open_.begin(); i != open_.end();) {
+        if (i->second > now) {
+            ++i;
+            continue;
+        }
+        // the page is protected before evaluation, a later write faults again
+        protect(i->first, true);
+        settled.push_back(i->first);
+        i = open_.erase(i);
+    }
+    if (settled.empty()) return;
+    for(std::size_t i = 0; i < stimuli_.size();) {
+        const auto entry = stimuli_[i];
+        const bool affected = std::ranges::any_of(settled, [&entry](auto page) noexcept {
+            return entry.first <= page && page < entry.last;
+        });
+        if (affected && evaluate(entry))
+            stimuli_.erase(stimuli_.begin() + static_cast<std::ptrdiff_t>(i));
+        else
+            ++i;
+    }
+}
+
+void write_watcher::run(std::stop_token stop) noexcept {
+    try {
+        std::array<pollfd, 2> fds {{ { uffd_, POLLIN, 0 }, { wakeup_, POLLIN, 0 } }};
+        while(! stop.stop_requested()) {
+            std::optional<timespec> timeout {};
+            {
+                std::lock_guard lock { mutex_ };
+                if (! open_.empty()) {
+                    const auto deadline = std::ranges::min(open_ | std::views::values);
+                    const auto left = std::max(clock::duration::zero(), deadline - clock::now());
+                    const auto seconds = std::chrono::duration_cast<std::chrono::seconds>(left);
+                    timeout = timespec { seconds.count(), std::chrono::duration_cast<std::chrono::nanoseconds>(left - seconds).count() };
+                }
+            }
+            if (ppoll(fds.data(), fds.size(), timeout ? &*timeout : nullptr, nullptr) < 0 && errno != EINTR) {
+                log::critical{}.format("ppoll error {}: {}", errno, strerror(errno));
+                return;
+            }
+            if ((fds[1].revents & POLLIN) != 0) {
+                std::uint64_t value {};
+                static_cast<void>(read(wakeup_, &value, sizeof(value)));
+            }
+            uffd_msg message {};
+            while(read(uffd_, &message, sizeof(message)) == sizeof(message)) {
+                if (message.event == UFFD_EVENT_PAGEFAULT)
+                    fault(message.arg.pagefault.address / detail::page_size * detail::page_size);
+            }
+            settle();
+        }
+    } catch(...) {
+        log::alert("Write watcher thread terminated with unknown exception");
+    }
+}
+
+/// shard - polls its share of active stimuli on a background thread.
+/// The thread owns the list of stimuli, other threads submit their requests via a lock-free stack
+/// and wait for completion, so the polling loop takes no locks.
+class shard {
+public:
+    explicit shard(int cpu) : cpu_ { cpu }, thread_ { start() } {}
+    shard(const shard&) = delete;
+    shard(shard&&) = delete;
+    shard& operator=(const shard&) = delete;
+    shard& operator=(shard&&) = delete;
+    ~shard() {
+        terminate();
+        alive_.wait(true);
+        log_stalls();
+        // the thread does not exist in a forked process, its handle is abandoned
+        if (forked_) static_cast<void>(thread_.release());
+    }
+    void activate(istimulus&);
+    bool deactivate(istimulus&);
+    void unmapping(detail::volatile_span, std::source_location);
+    /// runs actions, which delays have expired by the simulated clock
+    void advance();
+    void terminate() noexcept {
+        terminate_ = true;
+        wake();
+    }
+    std::size_t size() const noexcept {
+        return size_.load(std::memory_order_acquire);
+    }
+    /// parks the thread between polls, so that a forked child inherits a consistent list
+    void prepare_fork() noexcept;
+    void parent_forked() noexcept;
+    void child_forked() noexcept;
+    auto& stats() noexcept { return stats_; }
+    static inline std::atomic<unsigned> spins_ { 16 };
+    static inline std::atomic<unsigned> yields_ { 64 };
+    static inline std::atomic<std::chrono::microseconds::rep> sleep_ { 500 };
+    static inline std::atomic<istimulus::clock_type> clock_ {};
+    static inline std::atomic<std::uint64_t> simulated_ {};
+    /// runs actions, which delays have expired by the current time
+    void expire_timers();
+private:
+    struct request {
+        enum class kind_type { activate, deactivate, unmapping, timers };
+        kind_type kind;
+        istimulus* stimulus;
+        detail::volatile_span range {};
+        std::source_location location {};
+        request* next {};
+        bool result {};
+        std::atomic<bool> completed {};
+    };
+    void run() noexcept;
+    std::unique_ptr<std::jthread> start() {
+        alive_ = true;
+        return std::make_unique<std::jthread>([this]() noexcept { run(); });
+    }
+    void restart();
+    /// pins the thread to cpu_
+    void pin() noexcept;
+    /// submits the request and waits for its completion.
+    /// A stimulus may submit to its own shard and to another one, unless that one waits for this one,
+    /// directly or through others, in which case stimulus_deadlock is thrown
+    bool submit(request&);
+    /// applies pending requests, called by the owner of the list, returns true if there were any
+    bool drain();
+    void apply(request&);
+    void add(istimulus*);
+    /// removes the stimulus from polling in O(1), keeping the not yet polled ones after current_index_
+    void remove(std::size_t index);
+    /// adds pages of the stimulus to the page index
+    void index(istimulus*);
+    void unindex(istimulus*) noexcept;
+    /// returns true if stimuli of this shard may use pages of the range
+    bool touches(detail::volatile_span range) const noexcept;
+    /// returns first and last pages of the span
+    static std::pair<std::uintptr_t, std::uintptr_t> pages_of(detail::volatile_span) noexcept;
+    /// polls one stimulus, returns true if it is done or scheduled
+    bool poll();
+    struct timed {
+        istimulus* stimulus;
+        std::uint64_t id;
+        std::uint64_t met;  ///< steady time when the condition was met
+    };
+    /// schedules the action of the stimulus, which condition is met
+    void schedule(istimulus&);
+    /// runs the action of the scheduled stimulus, unless it has been deactivated
+    void expire(timed);
+    /// current time of the clock in nanoseconds
+    static std::uint64_t now() noexcept;
+    void update_size() noexcept {
+        size_.store(stimuli_.size() + scheduled_.size(), std::memory_order_release);
+    }
+    /// wakes the thread if it sleeps
+    void wake() noexcept;
+    /// sleeps until wake or for the duration in nanoseconds, if signal_ still equals signal
+    void sleep(std::uint32_t signal, std::optional<std::uint64_t> duration) noexcept;
+    /// returns nanoseconds until the next timer event of the steady clock
+    std::optional<std::uint64_t> timer_wait() const noexcept;
+    /// pauses after idle_rounds rounds over all stimuli without progress
+    void backoff(std::size_t idle_rounds, std::uint32_t signal);
+    void log_stalls();
+    static inline thread_local shard* polling_ {};
+    const int cpu_;
+    std::vector<istimulus*> stimuli_ {};
+    std::unordered_map<istimulus*, std::size_t> index_ {};
+    std::size_t current_index_ {};
+    /// scheduled stimuli with their timer id, a timer of a deactivated stimulus is ignored when expired
+    std::unordered_map<istimulus*, std::uint64_t> scheduled_ {};
+    std::uint64_t last_id_ {};
+    /// active stimuli by the pages they use
+    std::multimap<std::uintptr_t, istimulus*> pages_ {};
+    /// bit per page modulo 64 of the page index, checked by other threads
+    std::atomic<std::uint64_t> page_filter_ {};
+    detail::timerwheel<timed> timers_ { now() };
+    detail::timerwheel<timed> tick_timers_ {};
+    istimulus::clock_type timers_clock_ { clock_ };
+    std::atomic<request*> requests_ {};
+    /// shard, which completion of a request a stimulus of this shard waits for
+    std::atomic<shard*> awaited_ {};
+    std::atomic<std::size_t> size_ {};
+    /// guards the list when the thread is not running
+    std::mutex control_ {};
+    std::atomic<bool> terminate_ {};
+    std::atomic<bool> alive_ {};
+    std::atomic<bool> pause_ {};
+    std::atomic<bool> parked_ {};
+    std::atomic<std::uint32_t> signal_ {};
+    counters stats_ {};
+    bool forked_ {};
+    /// started after all other members are initialized
+    std::unique_ptr<std::jthread> thread_;
+    using log = logovod::logger<logcategory::stimulus>;
+};
+
+/// stimulator - pool of shards, a stimulus is polled by the shard selected by its group or watched page
 class stimulator : detail::mmio::listener {
 public:
-    stimulator() : thread_ { [this]() noexcept { run(); } } {
+    stimulator() {
+        resize(istimulus::pool_type { 1, {} });
         detail::mmio::arena().subscribe(this);
+        [[maybe_unused]] static const auto registered = pthread_atfork(&prepare_fork, &parent_forked, &child_forked);
+        forkable_ = this;
     }
     // instance to be created on first use
     static stimulator& instance() {
@@ -36,31 +1160,44 @@ public:
     void activate(istimulus&);
     bool deactivate(istimulus&);
     void terminate() noexcept {
-        terminate_ = true;
+        for(auto& item : shards_) item->terminate();
     }
     virtual ~stimulator() {
-        log_stalls();
-        terminate();
+        forkable_ = nullptr;
+        destroyed_ = true;
         detail::mmio::arena().unsubscribe(this);
     }
-    auto count() {
-        std::lock_guard lock { mutex_ };
-        return stimuli_.size();
+    /// true after destruction, when static stimuli are destroyed
+    static inline bool destroyed_ {};
+    std::size_t count() {
+        std::size_t result = (trapper::active_ != nullptr ? trapper::active_->count() : 0)
+             + (write_watcher::active_ != nullptr ? write_watcher::active_->count() : 0);
+        for(const auto& item : shards_) result += item->size();
+        return result;
+    }
+    bool configure(const istimulus::pool_type&);
+    bool clock(istimulus::clock_type);
+    void advance(std::chrono::nanoseconds);
+    istimulus::pool_type configuration() const {
+        return config_;
     }
+    istimulus::stats_type stats() const;
+    void reset_stats() noexcept;
+    static inline istimulus::mode_type mode_ {};
 private:
-    void run() noexcept;
     void unmapping(detail::volatile_span, std::source_location) override;
-    using pos_type = std::make_signed_t<std::size_t>;
-    void adjust_index(auto);
-    std::jthread thread_;
-    std::vector<istimulus*> stimuli_ {};
-    std::mutex mutex_ {};
-    std::size_t current_index_ {};
-    volatile bool terminate_ {};
-    volatile bool ready_ {};
+    void resize(const istimulus::pool_type&);
+    shard& select(istimulus&);
+    static void prepare_fork() noexcept;
+    static void parent_forked() noexcept;
+    static void child_forked() noexcept;
+    static inline stimulator* forkable_ {};
     static void check_pages(const auto& list, std::source_location location);
-    void log_stalls();
-    using log = logovod::logger<logcategory::stimulus>;
+    std::vector<std::unique_ptr<shard>> shards_ {};
+    istimulus::pool_type config_ {};
+    /// counters of shards, removed by resize
+    counters retired_ {};
+    std::atomic<std::uint64_t> started_ { steady_time() };
 };
 
 static bool contains(detail::volatile_span range, detail::volatile_span addresses) {
@@ -68,28 +1205,6 @@ static bool contains(detail::volatile_span range, detail::volatile_span addresse
            (range.begin() <= addresses.end() && addresses.end() <= range.end());
 }
 
-void stimulator::unmapping(detail::volatile_span range, std::source_location location) {
-    std::lock_guard lock {mutex_};
-    if (stimuli_.empty()) return; // nothing to do if no stimuli
-    std::size_t putpos = 0;
-    for(std::size_t i = 0; i < stimuli_.size(); ++i) {
-        istimulus* stimul = stimuli_[i];
-        const auto spans { stimul->spans() };
-        const auto found = std::find_if(spans.begin(), spans.end(), [range](auto sp){ return contains(range, sp); });
-        if (found == spans.end()) {
-            stimuli_[putpos++] = stimul;
-        } else {
-            adjust_index(i);
-            log::error{}.format("Removing stimulus because it uses stub page being deallocated\n"
-                "Stimulus defined at {}:{}:\nStub defined at {}:{}\n",
-                stimul->location_.file_name(), stimul->location_.line(), location.file_name(), location.line());
-        }
-    }
-    if (putpos != stimuli_.size())
-        stimuli_.erase(stimuli_.begin() + static_cast<pos_type>(putpos), stimuli_.end());
-}
-
-
 void stimulator::check_pages(const auto& list, std::source_location location) {
     for(const auto& el : list) {
         if(reinterpret_cast<std::uintptr_t>(&el.front()) < arena::size() && ! detail::mmio::arena().contains(el)) {
@@ -100,79 +1215,519 @@ void stimulator::check_pages(const auto& list, std::source_location location) {
     }
 }
 
-void stimulator::activate(istimulus& stimul) {
-    check_pages(stimul.spans(), stimul.location_);
-    std::lock_guard lock {mutex_};
-    auto found = std::find(stimuli_.begin(), stimuli_.end(), &stimul);
-    if (found != stimuli_.end())
+void shard::restart() {
+    // the thread does not exist in a forked process, its handle is abandoned
+    static_cast<void>(thread_.release());
+    thread_ = start();
+    forked_ = false;
+}
+
+bool shard::submit(request& req) {
+    if (polling_ == this) { // called from a stimulus, the list is owned by this thread
+        apply(req);
+        return req.result;
+    }
+    // called from a stimulus of another shard, the wait is published before checking for a cycle,
+    // so of the shards waiting in a cycle at least the last one sees it
+    const auto waiter = polling_;
+    if (waiter != nullptr) {
+        waiter->awaited_.store(this);
+        for(auto awaited = awaited_.load(); awaited != nullptr; awaited = awaited->awaited_.load()) {
+            if (awaited != waiter) continue;
+            waiter->awaited_.store(nullptr);
+            throw exceptions::stimulus_deadlock{"stimulus submits to a worker, which waits for the stimulus' one"};
+        }
+    }
+    req.next = requests_.load(std::memory_order_relaxed);
+    while(! requests_.compare_exchange_weak(req.next, &req));
+    if (alive_) {
+        // the thread applies all requests pushed before it has stopped
+        wake();
+        req.completed.wait(false, std::memory_order_acquire);
+    } else {
+        std::lock_guard lock { control_ };
+        drain();
+    }
+    if (waiter != nullptr) waiter->awaited_.store(nullptr);
+    return req.result;
+}
+
+bool shard::drain() {
+    request* fifo {};
+    for(auto list = requests_.exchange(nullptr); list != nullptr;)
+        list = std::exchange(list->next, std::exchange(fifo, list));
+    if (fifo == nullptr) return false;
+    const auto start = steady_time();
+    while(fifo != nullptr) {
+        // the request is gone once completed
+        auto& req = *std::exchange(fifo, fifo->next);
+        apply(req);
+        req.completed.store(true, std::memory_order_release);
+        req.completed.notify_one();
+    }
+    counters::add(stats_.requests, steady_time() - start);
+    return true;
+}
+
+void shard::apply(request& req) {
+    switch(req.kind) {
+    case request::kind_type::activate:
+        req.result = ! index_.contains(req.stimulus) && ! scheduled_.contains(req.stimulus);
+        if (req.result) add(req.stimulus);
         return;
-    stimuli_.push_back(&stimul);
-    stimul.active();
-    ready_ = true;
+    case request::kind_type::deactivate: {
+        const auto found = index_.find(req.stimulus);
+        req.result = found != index_.end() || scheduled_.erase(req.stimulus) != 0;
+        if (! req.result) return;
+        if (found != index_.end()) remove(found->second);
+        unindex(req.stimulus);
+        update_size();
+        req.stimulus->inactive();
+        return;
+    }
+    case request::kind_type::timers:
+        expire_timers();
+        return;
+    case request::kind_type::unmapping: {
+        const auto [first, last] = pages_of(req.range);
+        std::vector<istimulus*> found {};
+        for(auto i = pages_.lower_bound(first); i != pages_.end() && i->first <= last; ++i)
+            found.push_back(i->second);
+        std::ranges::sort(found);
+        const auto [dups, end] = std::ranges::unique(found);
+        found.erase(dups, end);
+        for(const auto stimul : found) {
+            unindex(stimul);
+            if (const auto position = index_.find(stimul); position != index_.end())
+                remove(position->second);
+            scheduled_.erase(stimul);
+            log::error{}.format("Removing stimulus because it uses stub page being deallocated\n"
+                "Stimulus defined at {}:{}:\nStub defined at {}:{}\n",
+                stimul->location_.file_name(), stimul->location_.line(),
+                req.location.file_name(), req.location.line());
+        }
+        counters::add(stats_.removed, found.size());
+        update_size();
+        return;
+    }
+    default:
+        return;
+    }
+}
+
+void shard::add(istimulus* stimul) {
+    index_.emplace(stimul, stimuli_.size());
+    stimuli_.push_back(stimul);
+    index(stimul);
+    stimul->active();
+    update_size();
 }
 
-void stimulator::adjust_index(auto index_removed) {
-  if (! stimuli_.empty() && static_cast<std::size_t>(index_removed) < (current_index_ % stimuli_.size())) {
-         --current_index_;
+std::pair<std::uintptr_t, std::uintptr_t> shard::pages_of(detail::volatile_span span) noexcept {
+    const auto begin = reinterpret_cast<std::uintptr_t>(span.data());
+    return { begin / detail::page_size, (begin + std::max<std::size_t>(span.size(), 1) - 1) / detail::page_size };
+}
+
+void shard::index(istimulus* stimul) {
+    auto filter = page_filter_.load(std::memory_order_relaxed);
+    for(const auto span : stimul->spans_) {
+        const auto [first, last] = pages_of(span);
+        for(auto page = first; page <= last; ++page) {
+            pages_.emplace(page, stimul);
+            filter |= 1ULL << (page % 64);
+        }
     }
+    page_filter_.store(filter, std::memory_order_release);
 }
 
-bool stimulator::deactivate(istimulus& stimul) {
-    std::lock_guard lock {mutex_};
-    const auto found = std::find(stimuli_.begin(), stimuli_.end(), &stimul);
-    if (found == stimuli_.end())
+void shard::unindex(istimulus* stimul) noexcept {
+    for(const auto span : stimul->spans_) {
+        const auto [first, last] = pages_of(span);
+        for(auto page = first; page <= last; ++page) {
+            const auto [begin, end] = pages_.equal_range(page);
+            for(auto i = begin; i != end;)
+                i = i->second == stimul ? pages_.erase(i) : std::next(i);
+        }
+    }
+    // the filter is not narrowed on removal, only reset when there are no pages
+    if (pages_.empty()) page_filter_.store(0, std::memory_order_release);
+}
+
+bool shard::touches(detail::volatile_span range) const noexcept {
+    const auto [first, last] = pages_of(range);
+    if (last - first >= 64) return size_ != 0;
+    std::uint64_t bits {};
+    for(auto page = first; page <= last; ++page) bits |= 1ULL << (page % 64);
+    return (page_filter_.load(std::memory_order_acquire) & bits) != 0;
+}
+
+void shard::remove(std::size_t index) {
+    const auto move = [this](std::size_t from, std::size_t to) {
+        if (from == to) return;
+        stimuli_[to] = stimuli_[from];
+        index_[stimuli_[to]] = to;
+    };
+    const auto last = stimuli_.size() - 1;
+    index_.erase(stimuli_[index]);
+    if (index < current_index_) {
+        // an already polled one fills the gap, the last one becomes next to poll
+        move(current_index_ - 1, index);
+        move(last, --current_index_);
+    } else {
+        move(last, index);
+    }
+    stimuli_.pop_back();
+    if (current_index_ >= stimuli_.size())
+        current_index_ = 0;
+    update_size();
+}
+
+void shard::activate(istimulus& stimul) {
+    if (forked_) {
+        std::lock_guard lock { control_ };
+        if (forked_) restart();
+    }
+    request req { request::kind_type::activate, &stimul };
+    submit(req);
+}
+
+bool shard::deactivate(istimulus& stimul) {
+    if (size_ == 0)
         return false;
-    adjust_index(found - stimuli_.begin());
-    std::erase(stimuli_, &stimul);
-    stimul.inactive();
-    ready_ = ! stimuli_.empty();
+    request req { request::kind_type::deactivate, &stimul };
+    return submit(req);
+}
+
+void shard::unmapping(detail::volatile_span range, std::source_location location) {
+    if (! touches(range)) return; // nothing to do if no stimuli use the pages
+    request req { request::kind_type::unmapping, nullptr, range, location };
+    submit(req);
+}
+
+void shard::advance() {
+    if (size_ == 0) return;
+    request req { request::kind_type::timers, nullptr };
+    submit(req);
+}
+
+void shard::prepare_fork() noexcept {
+    control_.lock();
+    pause_ = true;
+    wake();
+    while(alive_ && ! parked_) std::this_thread::yield();
+}
+
+void shard::parent_forked() noexcept {
+    pause_ = false;
+    pause_.notify_one();
+    control_.unlock();
+}
+
+void shard::child_forked() noexcept {
+    forked_ = true;
+    alive_ = false;
+    parked_ = false;
+    pause_ = false;
+    control_.unlock();
+}
+
+void stimulator::prepare_fork() noexcept {
+    if (forkable_ == nullptr) return;
+    for(auto& item : forkable_->shards_) item->prepare_fork();
+}
+
+void stimulator::parent_forked() noexcept {
+    if (forkable_ == nullptr) return;
+    for(auto& item : forkable_->shards_) item->parent_forked();
+}
+
+void stimulator::child_forked() noexcept {
+    if (forkable_ == nullptr) return;
+    for(auto& item : forkable_->shards_) item->child_forked();
+}
+
+void stimulator::unmapping(detail::volatile_span range, std::source_location location) {
+    if (trapper::active_ != nullptr) trapper::active_->unmapping(range, location);
+    if (write_watcher::active_ != nullptr) write_watcher::active_->unmapping(range, location);
+    for(auto& item : shards_) item->unmapping(range, location);
+}
+
+void stimulator::resize(const istimulus::pool_type& config) {
+    for(auto& item : shards_) retired_.merge(item->stats());
+    shards_.clear();
+    for(unsigned i = 0; i < config.workers; ++i)
+        shards_.push_back(std::make_unique<shard>(i < config.cpus.size() ? config.cpus[i] : -1));
+    config_ = config;
+}
+
+bool stimulator::configure(const istimulus::pool_type& config) {
+    if (config.workers == 0 || std::ranges::any_of(shards_, [](const auto& item) noexcept { return item->size() != 0; }))
+        return false;
+    resize(config);
+    return true;
+}
+
+bool stimulator::clock(istimulus::clock_type value) {
+    if (std::ranges::any_of(shards_, [](const auto& item) noexcept { return item->size() != 0; }))
+        return false;
+    shard::clock_ = value;
     return true;
 }
 
-void stimulator::run() noexcept {
+void stimulator::advance(std::chrono::nanoseconds duration) {
+    shard::simulated_ += static_cast<std::uint64_t>(duration.count());
+    if (shard::clock_ != istimulus::clock_type::simulated) return;
+    for(auto& item : shards_) item->advance();
+}
+
+istimulus::stats_type stimulator::stats() const {
+    istimulus::stats_type result {};
+    result.elapsed = std::chrono::nanoseconds { steady_time() - started_.load(std::memory_order_relaxed) };
+    shared_counters.collect(result);
+    retired_.collect(result);
+    for(const auto& item : shards_) item->stats().collect(result);
+    return result;
+}
+
+void stimulator::reset_stats() noexcept {
+    shared_counters.reset();
+    retired_.reset();
+    for(const auto& item : shards_) item->stats().reset();
+    started_.store(steady_time(), std::memory_order_relaxed);
+}
+
+shard& stimulator::select(istimulus& stimul) {
+    if (shards_.size() == 1) return *shards_.front();
+    const auto key = stimul.group_ != istimulus::no_group ? stimul.group_
+        : reinterpret_cast<std::uintptr_t>(stimul.spans_.front().data()) / detail::page_size;
+    return *shards_[key % shards_.size()];
+}
+
+void stimulator::activate(istimulus& stimul) {
+    check_pages(stimul.spans_, stimul.location_);
+    const bool delayed = stimul.delay_time_.count() != 0 || stimul.delay_ticks_ != istimulus::ticks {};
+    if (! delayed && mode_ == istimulus::mode_type::trap && trapper::instance().activate(stimul))
+        return;
+    if (! delayed && mode_ == istimulus::mode_type::userfault && write_watcher::instance().activate(stimul))
+        return;
+    select(stimul).activate(stimul);
+}
+
+bool stimulator::deactivate(istimulus& stimul) {
+    if (trapper::active_ != nullptr && trapper::active_->deactivate(stimul))
+        return true;
+    if (write_watcher::active_ != nullptr && write_watcher::active_->deactivate(stimul))
+        return true;
+    return select(stimul).deactivate(stimul);
+}
+
+bool shard::poll() {
+    auto stimul { stimuli_[current_index_] };
+    bool finished {};
+    bool delayed {};
+    counters::add(stats_.polls);
     try {
-        for(; !terminate_; std::this_thread::yield()) {
-            std::unique_lock lock {mutex_};
-            while(!(ready_ || terminate_)) {
-                lock.unlock();
-                std::this_thread::yield();
-                lock.lock();
+        delayed = stimul->delay_time_.count() != 0 || stimul->delay_ticks_ != istimulus::ticks {};
+        if (delayed) {
+            stimul->status_ = istimulus::status_type::running;
+            finished = stimul->evaluate();
+        } else {
+            finished = stimul->running() == istimulus::status_type::done;
+        }
+    } catch(const std::exception& error) {
+        delayed = false;
+        log::error{}.format("Exception caught when running stimulus defined at {}:{}:\n{}",
+                stimul->location_.file_name(), stimul->location_.line(), error.what());
+        finished = true;
+    }
+    const auto found = index_.find(stimul);
+    if (found == index_.end()) // the stimulus has deactivated itself
+        return true;
+    if (finished)
+        remove(found->second);
+    else if (++current_index_ >= stimuli_.size())
+        current_index_ = 0;
+    if (finished && delayed)
+        schedule(*stimul);
+    else if (finished)
+        unindex(stimul);
+    return finished;
+}
+
+std::uint64_t shard::now() noexcept {
+    if (clock_ == istimulus::clock_type::simulated)
+        return simulated_;
+    return steady_time();
+}
+
+void shard::schedule(istimulus& stimul) {
+    const timed timer { &stimul, ++last_id_, steady_time() };
+    scheduled_.insert_or_assign(&stimul, timer.id);
+    if (stimul.delay_ticks_ != istimulus::ticks {})
+        tick_timers_.schedule(tick_timers_.now() + static_cast<std::uint64_t>(stimul.delay_ticks_), timer);
+    else
+        timers_.schedule(now() + static_cast<std::uint64_t>(stimul.delay_time_.count()), timer);
+    stimul.status_ = istimulus::status_type::scheduled;
+    update_size();
+}
+
+void shard::expire(timed timer) {
+    const auto found = scheduled_.find(timer.stimulus);
+    if (found == scheduled_.end() || found->second != timer.id)
+        return;
+    scheduled_.erase(found);
+    unindex(timer.stimulus);
+    update_size();
+    auto& stimul = *timer.stimulus;
+    try {
+        stimul.complete(timer.met);
+        stimul.status_ = istimulus::status_type::done;
+    } catch(const std::exception& error) {
+        log::error{}.format("Exception caught when running stimulus defined at {}:{}:\n{}",
+                stimul.location_.file_name(), stimul.location_.line(), error.what());
+    }
+}
+
+void shard::expire_timers() {
+    if (timers_clock_ != clock_) {
+        // clock changes when no stimulus is active, so there are no timers to keep
+        timers_clock_ = clock_;
+        timers_ = detail::timerwheel<timed> { now() };
+    }
+    timers_.advance(now(), [this](timed timer) { expire(timer); });
+}
+
+// signal_ is a futex word
+static_assert(std::atomic<std::uint32_t>::is_always_lock_free && sizeof(std::atomic<std::uint32_t>) == sizeof(std::uint32_t));
+
+void shard::wake() noexcept {
+    signal_.fetch_add(1);
+    syscall(SYS_futex, reinterpret_cast<std::uint32_t*>(&signal_), FUTEX_WAKE_PRIVATE, 1, nullptr, nullptr, 0);
+}
+
+void shard::sleep(std::uint32_t signal, std::optional<std::uint64_t> duration) noexcept {
+    timespec timeout {};
+    if (duration) {
+        timeout.tv_sec = static_cast<time_t>(*duration / 1000000000);
+        timeout.tv_nsec = static_cast<long>(*duration % 1000000000);
+    }
+    syscall(SYS_futex, reinterpret_cast<std::uint32_t*>(&signal_), FUTEX_WAIT_PRIVATE, signal,
+        duration ? &timeout : nullptr, nullptr, 0);
+}
+
+std::optional<std::uint64_t> shard::timer_wait() const noexcept {
+    // the simulated clock is advanced with a request, which wakes the thread
+    if (clock_ == istimulus::clock_type::simulated) return std::nullopt;
+    const auto next = timers_.next_event();
+    if (! next) return std::nullopt;
+    const auto current = now();
+    return *next > current ? *next - current : 0;
+}
+
+void shard::backoff(std::size_t rounds, std::uint32_t signal) {
+    const auto spins = spins_.load(std::memory_order_relaxed);
+    const auto yields = yields_.load(std::memory_order_relaxed);
+    if (rounds < spins) {
+#if defined(__x86_64__) || defined(__i386__)
+        __builtin_ia32_pause();
+#endif
+        return;
+    }
+    if (rounds < spins + yields) {
+        std::this_thread::yield();
+        return;
+    }
+    // the sleep doubles each round, starting from a microsecond, and ends early on a request
+    const auto sleeps = std::min<std::size_t>(rounds - spins - yields, 20);
+    const auto limit = sleep_.load(std::memory_order_relaxed);
+    const auto duration = std::min<std::uint64_t>(std::uint64_t { 1000 } << sleeps, static_cast<std::uint64_t>(limit) * 1000);
+    sleep(signal, std::min(timer_wait().value_or(duration), duration));
+}
+
+void shard::run() noexcept {
+    polling_ = this;
+    counters::worker_ = &stats_;
+    if (cpu_ >= 0) pin();
+    try {
+        // a round polls each stimulus once, the pause after an idle round keeps latency within the sleep limit
+        std::size_t idle_rounds = 0;
+        for(bool progress = false; ! terminate_;) {
+            const auto signal = signal_.load();
+            if (pause_) {
+                parked_ = true;
+                pause_.wait(true);
+                parked_ = false;
             }
-            if (terminate_ || stimuli_.empty()) continue;
-            auto stimul { stimuli_[current_index_ % stimuli_.size()] };
-            try {
-                const auto status = stimul->running();
-                if (status == istimulus::status_type::done) {
-                    std::erase(stimuli_, stimul);
-                } else {
-                    ++current_index_;
-                }
-            } catch(const std::exception& error) {
-                log::error{}.format("Exception caught when running stimulus defined at {}:{}:\n{}",
-                        stimul->location_.file_name(), stimul->location_.line(), error.what());
-                std::erase(stimuli_, stimul);
+            if (drain()) progress = true;
+            expire_timers();
+            if (stimuli_.empty()) {
+                // with nothing to poll, ticks do not matter, the next tick timer expires right away
+                if (const auto next = tick_timers_.next_event())
+                    tick_timers_.advance(*next, [this](timed timer) { expire(timer); });
+                else if (requests_.load() == nullptr && ! terminate_ && ! pause_)
+                    sleep(signal, timer_wait());
+                continue;
             }
+            tick_timers_.advance(tick_timers_.now() + 1, [this](timed timer) { expire(timer); });
+            if (poll())
+                progress = true;
+            if (current_index_ != 0 || stimuli_.empty())
+                continue;
+            if (progress)
+                idle_rounds = 0;
+            else
+                backoff(idle_rounds++, signal);
+            progress = false;
         }
     } catch(...) {
         log::alert("Stimulator thread terminated with unknown exception");
     }
+    alive_ = false;
+    alive_.notify_all();
+    // requests pushed before the thread has stopped
+    std::lock_guard lock { control_ };
+    drain();
+}
+
+void shard::pin() noexcept {
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(static_cast<std::size_t>(cpu_), &set);
+    if (const auto error = pthread_setaffinity_np(pthread_self(), sizeof(set), &set); error != 0)
+        log::error{}.format("Pinning stimulator worker to CPU {} has failed: {}", cpu_, strerror(error));
 }
 
-void stimulator::log_stalls() {
-    std::lock_guard lock {mutex_};
+void shard::log_stalls() {
+    std::lock_guard lock {control_};
     if(!stimuli_.empty()) {
         log::error{}.format("{} stall stimuli has not finished:\n", stimuli_.size());
         for(auto stimul : stimuli_) {
             log::error{}.format("Stimulus defined at {}:{}:\n", stimul->location_.file_name(), stimul->location_.line());
         }
     }
+    if(!scheduled_.empty()) {
+        log::error{}.format("{} stall stimuli has not acted:\n", scheduled_.size());
+        for(const auto& item : scheduled_) {
+            log::error{}.format("Stimulus defined at {}:{}:\n", item.first->location_.file_name(), item.first->location_.line());
+        }
+    }
+}
+
+void detail::restore_pages(volatile_span addresses) {
+    // the watcher touches the pages, so they are protected by the trapper after it
+    std::vector<istimulus*> polled {};
+    if (write_watcher::active_ != nullptr) polled = write_watcher::active_->remapped(addresses);
+    if (trapper::active_ != nullptr) trapper::active_->restore(addresses);
+    for(auto stimul : polled) stimulator::instance().activate(*stimul);
 }
 
 void istimulus::activate(istimulus& stimul) {
+    stimul.spans_ = stimul.spans();
     stimulator::instance().activate(stimul);
 }
 
 bool istimulus::deactivate(istimulus& stimul) {
+    if (stimulator::destroyed_) return false;
     return stimulator::instance().deactivate(stimul);
 }
 
@@ -184,6 +1739,116 @@ void istimulus::terminate() {
     return stimulator::instance().terminate();
 }
 
+bool istimulus::mode(mode_type value) {
+    if (value == mode_type::trap && ! trapper::supported)
+        return false;
+    if (value == mode_type::userfault && ! write_watcher::supported())
+        return false;
+    stimulator::mode_ = value;
+    return true;
+}
+
+istimulus::mode_type istimulus::mode() noexcept {
+    return stimulator::mode_;
+}
+
+void istimulus::backoff(const backoff_type& value) noexcept {
+    shard::spins_ = value.spins;
+    shard::yields_ = value.yields;
+    shard::sleep_ = value.sleep.count();
+}
+
+istimulus::backoff_type istimulus::backoff() noexcept {
+    return { shard::spins_, shard::yields_, std::chrono::microseconds { shard::sleep_ } };
+}
+
+bool istimulus::pool(const pool_type& value) {
+    return stimulator::instance().configure(value);
+}
+
+istimulus::pool_type istimulus::pool() {
+    return stimulator::instance().configuration();
+}
+
+istimulus& istimulus::delay(std::chrono::nanoseconds value) {
+    const bool was_active = deactivate(*this);
+    delay_time_ = value;
+    delay_ticks_ = {};
+    if (was_active) activate(*this);
+    return *this;
+}
+
+istimulus& istimulus::delay(ticks value) {
+    const bool was_active = deactivate(*this);
+    delay_time_ = {};
+    delay_ticks_ = value;
+    if (was_active) activate(*this);
+    return *this;
+}
+
+bool istimulus::clock(clock_type value) {
+    return stimulator::instance().clock(value);
+}
+
+istimulus::clock_type istimulus::clock() noexcept {
+    return shard::clock_;
+}
+
+void istimulus::advance(std::chrono::nanoseconds duration) {
+    stimulator::instance().advance(duration);
+}
+
+istimulus::stats_type istimulus::stats() {
+    return stimulator::instance().stats();
+}
+
+void istimulus::reset_stats() {
+    stimulator::instance().reset_stats();
+}
+
+double istimulus::stats_type::poll_rate() const noexcept {
+    const std::chrono::duration<double> seconds = elapsed;
+    return seconds.count() > 0 ? static_cast<double>(polls) / seconds.count() : 0.0;
+}
+
+std::chrono::nanoseconds istimulus::stats_type::percentile(double percent) const noexcept {
+    const auto total = std::accumulate(latency.begin(), latency.end(), std::uint64_t {});
+    const auto rank = static_cast<std::uint64_t>(std::ceil(percent / 100.0 * static_cast<double>(total)));
+    std::uint64_t counted {};
+    for(std::size_t i = 0; i < latency.size(); ++i) {
+        counted += latency[i];
+        if (counted != 0 && counted >= rank) return std::chrono::nanoseconds { std::int64_t { 2 } << i };
+    }
+    return std::chrono::nanoseconds {};
+}
+
+bool istimulus::evaluate() {
+    // a stimulus is evaluated by one thread at a time, so the count is not incremented atomically
+    const std::atomic_ref count { evaluations_ };
+    count.store(count.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    counters::add(counters::local().evaluations);
+    return triggered();
+}
+
+void istimulus::complete(std::uint64_t met) {
+    perform();
+    counters::local().acted(steady_time() - met);
+}
+
+istimulus::status_type istimulus::run() {
+    if (! evaluate())
+        return status_type::idle;
+    complete(steady_time());
+    return status_type::done;
+}
+
+void istimulus::group(unsigned value) {
+    if (group_ == value) return;
+    const bool was_active = deactivate(*this);
+    group_ = value;
+    if (was_active) activate(*this);
+}
+
 
 } // namespace stubmmio
 
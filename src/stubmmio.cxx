@@ -12,8 +12,11 @@
 #include <format>
 #include <iostream>
 #include <algorithm>
+#include <cstring>
 #include <iterator>
+#include <utility>
 #include <vector>
+#include "compare.h"
 #include "mmio.h"
 
 namespace stubmmio {
@@ -93,6 +96,32 @@ static void check_overlapping(const stub::elements_type& elements, std::source_l
     }
 }
 
+void apply(const static_record& record, std::span<const std::byte> data) noexcept {
+    auto* destination = reinterpret_cast<std::byte*>(record.address);
+    const auto* value = data.data() + record.offset;
+    switch(record.kind) {
+    case static_kind::one:
+        std::memcpy(destination, value, record.value_size);
+        break;
+    case static_kind::all:
+        for(auto* end = destination + record.size; destination != end; destination += record.value_size)
+            std::memcpy(destination, value, record.value_size);
+        break;
+    case static_kind::none:
+    default:
+        break;
+    }
+}
+
+static stub::elements_type materialize(const static_table& table) {
+    stub::elements_type elements {};
+    for(const auto& record : table.records) {
+        elements.try_emplace(record.address, region{record.address, record.size},
+            [&record, data = table.data](void*, void*) noexcept { apply(record, data); }, record.location);
+    }
+    return elements;
+}
+
 } // namespace stubmmio::detail
 
 
@@ -108,10 +137,14 @@ stub::stub(std::initializer_list<initializer_list> lists, std::source_location l
     }
     detail::check_overlapping(elements_, location_);
 }
+stub::stub(elements_type elements, std::source_location location)
+ : elements_ { std::move(elements) }, location_(location) {
+    detail::check_overlapping(elements_, location_);
+}
 
 
 stub::stub(stub&& that)
- : elements_{std::move(that.elements_)}, location_{std::move(that.location_)} {
+ : elements_{std::move(that.elements_)}, table_{std::exchange(that.table_, {})}, location_{std::move(that.location_)} {
      detail::mmio::arena().claim(that, *this);
 }
 
@@ -119,7 +152,18 @@ stub::~stub() {
     detail::mmio::arena().deallocate(*this);
 }
 
+void stub::materialize() {
+    if (table_.empty()) return;
+    elements_ = detail::materialize(table_);
+    table_ = {};
+}
+
 stub& stub::operator|=(const stub& that) {
+    materialize();
+    if (! that.table_.empty()) {
+        const auto elements = detail::materialize(that.table_);
+        detail::append(elements_, elements.begin(), elements.end(), location_);
+    }
     detail::append(elements_, that.elements_.begin(), that.elements_.end(), location_);
     detail::check_overlapping(elements_, location_);
     return *this;
@@ -127,12 +171,15 @@ stub& stub::operator|=(const stub& that) {
 
 stub& stub::operator=(stub&& that) {
     elements_ = std::move(that.elements_);
+    table_ = std::exchange(that.table_, {});
     location_ = std::move(that.location_);
     detail::mmio::arena().claim(that, *this);
     return *this;
 }
 
 stub& stub::operator|=(stub&& that) {
+    materialize();
+    that.materialize();
     detail::append(elements_, std::make_move_iterator(that.elements_.begin()), std::make_move_iterator(that.elements_.end()), location_);
     detail::check_overlapping(elements_, location_);
     that.elements_.clear();
@@ -141,18 +188,42 @@ stub& stub::operator|=(stub&& that) {
 }
 
 void stub::apply() const {
+    if (! table_.empty()) {
+        // pages are joined and elements are ordered in compile time
+        detail::byteset bytes {};
+        for(const auto& record : table_.records) bytes.append({record.address, record.address + record.size});
+        for(const auto& pages : table_.pages) {
+            if(pages.address >= arena::size()) break;
+            detail::mmio::arena().allocate({reinterpret_cast<void*>(pages.address),
+                                            reinterpret_cast<void*>(pages.address + pages.size)}, *this, bytes);
+        }
+        for(const auto& record : table_.records) detail::apply(record, table_.data);
+        for(const auto& pages : table_.pages) {
+            if(pages.address >= arena::size()) break;
+            detail::mmio::arena().clean({reinterpret_cast<void*>(pages.address),
+                                         reinterpret_cast<void*>(pages.address + pages.size)});
+        }
+        return;
+    }
     std::vector<detail::pagerange> pages{};
+    detail::byteset bytes {};
     for(const auto& el : elements_) {
         if(el.first >= arena::size()) break;
+        bytes.append({el.first, el.first + el.second.size()});
         detail::pagerange page {el.second.begin(), el.second.end()};
-        if(pages.empty() || ! pages.front().join(page) ) {
+        // elements are ordered by address, so a page may only join the last range
+        if(pages.empty() || ! pages.back().join(page) ) {
             pages.push_back(page);
         }
     }
     for(const auto& page : pages) {
-        detail::mmio::arena().allocate(page, *this);
+        detail::mmio::arena().allocate(page, *this, bytes);
     }
     for(const auto& el : elements_) el.second();
+    // the pages are written since apply only by the code under test
+    for(const auto& page : pages) {
+        detail::mmio::arena().clean(page);
+    }
 }
 
 verify::verify(initializer_list elements, std::source_location location)
@@ -169,15 +240,44 @@ verify::verify(std::initializer_list<initializer_list> lists, std::source_locati
 
 verify& verify::operator|=(const verify& that) {
     detail::append(elements_, that.elements_.begin(), that.elements_.end(), location_);
+    stale_ = true;
     return *this;
 }
 
 verify& verify::operator|=(verify&& that) {
     detail::append(elements_, std::make_move_iterator(that.elements_.begin()), std::make_move_iterator(that.elements_.end()), location_);
     that.elements_.clear();
+    that.stale_ = true;
+    stale_ = true;
     return *this;
 }
 
+void verify::compile() const {
+    using kind_type = detail::verify_step::kind_type;
+    if (! stale_) return;
+    plan_.clear();
+    image_.clear();
+    for(const auto& [address, element] : elements_) {
+        const auto* pattern = element.operation().target<detail::pattern>();
+        if (pattern == nullptr) {
+            plan_.push_back({address, element.size(), 0, 0, 1, kind_type::opaque});
+            continue;
+        }
+        const auto bytes = std::span{pattern->bytes}.first(pattern->size);
+        if (pattern->kind == detail::pattern::kind_type::all) {
+            plan_.push_back({address, element.size() / pattern->size * pattern->size, image_.size(), pattern->size, 1, kind_type::fill});
+            image_.insert(image_.end(), bytes.begin(), bytes.end());
+            continue;
+        }
+        // adjacent values are compared as one image
+        if (plan_.empty() || plan_.back().kind != kind_type::image || plan_.back().address + plan_.back().size != address)
+            plan_.push_back({address, 0, image_.size(), 0, 0, kind_type::image});
+        plan_.back().size += pattern->size;
+        ++plan_.back().elements;
+        image_.insert(image_.end(), bytes.begin(), bytes.end());
+    }
+    stale_ = false;
+}
 
 verify::control verify::default_expect(bool success, std::source_location loc) {
     using log = logovod::logger<logcategory::verify>;
@@ -188,28 +288,124 @@ verify::control verify::default_expect(bool success, std::source_location loc) {
 }
 constinit verify::expect_signature verify::expect = &verify::default_expect;
 
-bool verify::apply() const {
-    for(const auto& el : elements_) {
-        if(el.first >= arena::size()) break;
-        detail::pagerange page {el.second.begin(), el.second.end()};
-        if(! detail::mmio::arena().contains(page)) {
+void verify::ensure_allocated() const {
+    auto el = elements_.begin();
+    for(const auto& step : plan_) {
+        if(step.address >= arena::size()) break;
+        const auto next = std::next(el, static_cast<std::ptrdiff_t>(step.elements));
+        const auto* begin = reinterpret_cast<const void*>(step.address);
+        if(! detail::mmio::arena().contains({begin, static_cast<const std::byte*>(begin) + step.size})) {
+            // the step is not covered, report the first element which is not
+            auto missing = std::find_if(el, next, [](const auto& element) {
+                return ! detail::mmio::arena().contains({element.second.begin(), element.second.end()});
+            });
+            if (missing == next) missing = el;
             throw exceptions::page_is_not_allocated{std::format(
                 "page is not allocated for element declared at {}:{}",
-                el.second.location().file_name(), el.second.location().line())};
+                missing->second.location().file_name(), missing->second.location().line())};
         }
+        el = next;
     }
+}
+
+bool verify::matches(const detail::verify_step& step) const {
+    const auto* data = reinterpret_cast<const std::byte*>(step.address);
+    const auto* expected = image_.data() + step.offset;
+    if (step.kind == detail::verify_step::kind_type::fill)
+        return detail::find_mismatch(data, step.size, expected, step.pattern_size) == step.size;
+    return detail::find_mismatch(data, expected, step.size) == step.size;
+}
+
+bool verify::apply() const {
+    compile();
+    ensure_allocated();
     bool fail = false;
-    for(const auto& el : elements_) {
-        const bool success = el.second();
-        fail |= !success;
-        if( expect(success, el.second.location()) == control::stop )
-            break;
+    auto el = elements_.begin();
+    for(const auto& step : plan_) {
+        const bool opaque = step.kind == detail::verify_step::kind_type::opaque;
+        const bool matched = opaque ? el->second() : matches(step);
+        for(std::size_t i = 0; i < step.elements; ++i, ++el) {
+            // elements of a mismatched step are compared one by one to find the failed ones
+            const bool success = matched || (! opaque && el->second());
+            fail |= !success;
+            if( expect(success, el->second.location()) == control::stop )
+                return !fail;
+        }
     }
     return !fail;
 }
 
-void set_page_fill(std::uint64_t value) noexcept {
-    detail::mmio::arena().set_fill(value);
+verify::report_type verify::mismatches() const {
+    using kind_type = detail::verify_step::kind_type;
+    compile();
+    ensure_allocated();
+    report_type report {};
+    auto actual = [](region::address_type address, std::size_t size) {
+        const auto* data = reinterpret_cast<const std::byte*>(address);
+        return std::vector<std::byte>(data, data + size);
+    };
+    auto el = elements_.begin();
+    for(const auto& step : plan_) {
+        const auto* data = reinterpret_cast<const std::byte*>(step.address);
+        const auto* expected = image_.data() + step.offset;
+        switch(step.kind) {
+        case kind_type::image: {
+            std::size_t begin = 0;
+            auto found = detail::find_mismatch(data, expected, step.size);
+            for(std::size_t i = 0; i < step.elements; ++i, ++el) {
+                const auto end = begin + el->second.operation().target<detail::pattern>()->size;
+                if (found < end) {
+                    report.push_back({el->first, {expected + begin, expected + end}, actual(el->first, end - begin), el->second.location()});
+                    found = end + detail::find_mismatch(data + end, expected + end, step.size - end);
+                }
+                begin = end;
+            }
+            break;
+        }
+        case kind_type::fill:
+            for(auto found = detail::find_mismatch(data, step.size, expected, step.pattern_size); found < step.size; ) {
+                const auto unit = found / step.pattern_size * step.pattern_size;
+                const auto next = unit + step.pattern_size;
+                report.push_back({step.address + unit, {expected, expected + step.pattern_size},
+                                  actual(step.address + unit, step.pattern_size), el->second.location()});
+                found = next + detail::find_mismatch(data + next, step.size - next, expected, step.pattern_size);
+            }
+            ++el;
+            break;
+        case kind_type::opaque:
+        default:
+            if (! el->second())
+                report.push_back({el->first, {}, actual(el->first, el->second.size()), el->second.location()});
+            ++el;
+            break;
+        }
+    }
+    return report;
+}
+
+std::vector<region> verify::unverified_writes() const {
+    auto holds_element = [this](region::address_type page) {
+        const auto next = elements_.lower_bound(page);
+        if (next != elements_.end() && next->first < page + detail::page_size)
+            return true;
+        // elements do not overlap, so only the preceding one may extend to the page
+        return next != elements_.begin() && std::prev(next)->first + std::prev(next)->second.size() > page;
+    };
+    std::vector<region> result {};
+    for(const auto& written : arena::written()) {
+        for(auto page = written.addr(); page < written.addr() + written.size(); page += detail::page_size) {
+            if (holds_element(page)) continue;
+            if (! result.empty() && result.back().addr() + result.back().size() == page)
+                result.back() = region { result.back().addr(), result.back().size() + detail::page_size };
+            else
+                result.push_back(region { page, detail::page_size });
+        }
+    }
+    return result;
+}
+
+void set_page_fill(std::uint64_t value, page_fill_type type) noexcept {
+    detail::mmio::arena().set_fill(value, type);
 }
 
 void set_page_nofill() noexcept {
@@ -0,0 +1,775 @@
+/*
+ * Copyright (C) 2025 Eugene Hutorny <eugene@hutorny.in.ua>
+ *
+ * src/svd.cxx - CMSIS-SVD importer and register table implementation
+ *
+ * Licensed under MIT License, see full text in LICENSE
+ * or visit page https://opensource.org/license/mit/
+ */
+
+#include <stubmmio/svd.h>
+#include <stubmmio/logger.h>
+
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+#include <format>
+#include <fstream>
+#include <istream>
+#include <optional>
+#include <ostream>
+#include <string>
+#include <system_error>
+#include <unordered_map>
+#include <utility>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace stubmmio::svd {
+namespace {
+using log = logovod::logger<logcategory::svd>;
+using exceptions::bad_svd_format;
+
+struct attribute {
+    std::string name;
+    std::string value;
+};
+using attributes = std::vector<attribute>;
+
+/// reader - streaming tokenizer of the XML subset, used in SVD files, reads the stream in chunks
+/// and passes elements and text to the handler, skipping declarations, processing instructions and comments
+class reader {
+public:
+    explicit reader(std::istream& stream) : stream_ { stream }, buffer_(chunk_size) {}
+    template<typename Handler>
+    void run(Handler& handler) {
+        std::string text {};
+        for(auto c = get(); c != eof; c = get()) {
+            if (c == '&') {
+                entity(text);
+                continue;
+            }
+            if (c != '<') {
+                text.push_back(static_cast<char>(c));
+                continue;
+            }
+            if (! text.empty()) {
+                if (! open_.empty()) handler.text(text);
+                text.clear();
+            }
+            markup(handler, text);
+        }
+        if (! open_.empty()) fail(std::format("element {} is not closed", open_.back()));
+    }
+private:
+    static constexpr int eof = -1;
+    static constexpr std::size_t chunk_size = 1 << 16;
+
+    int get() {
+        if (position_ == size_ && ! fill()) return eof;
+        const auto c = static_cast<unsigned char>(buffer_[position_++]);
+        if (c == '\n') ++line_;
+        return c;
+    }
+    int peek() {
+        if (position_ == size_ && ! fill()) return eof;
+        return static_cast<unsigned char>(buffer_[position_]);
+    }
+    bool fill() {
+        stream_.read(buffer_.data(), static_cast<std::streamsize>(buffer_.size()));
+        size_ = static_cast<std::size_t>(stream_.gcount());
+        position_ = 0;
+        return size_ != 0;
+    }
+    [[noreturn]] void fail(std::string_view what) const {
+        throw bad_svd_format{std::format("line {}: {}", line_, what)};
+    }
+    int expect(int c) {
+        const auto got = get();
+        if (got != c) fail(std::format("'{}' is expected", static_cast<char>(c)));
+        return got;
+    }
+    void skip_spaces() {
+        while(std::isspace(peek())) get();
+    }
+    static bool name_char(int c) noexcept {
+        return c != eof && ! std::isspace(c) && c != '>' && c != '/' && c != '=' && c != '<';
+    }
+    void read_name(std::string& name) {
+        name.clear();
+        while(name_char(peek())) name.push_back(static_cast<char>(get()));
+        if (name.empty()) fail("name is expected");
+    }
+    /// reads past the terminator, appending the characters before it to into
+    void read_past(std::string_view terminator, std::string& into) {
+        const auto start = into.size();
+        while(into.size() < start + terminator.size() || ! std::string_view{into}.ends_with(terminator)) {
+            const auto c = get();
+            if (c == eof) fail(std::format("'{}' is expected", terminator));
+            into.push_back(static_cast<char>(c));
+        }
+        into.resize(into.size() - terminator.size());
+    }
+    void skip_past(std::string_view terminator) {
+        scratch_.clear();
+        read_past(terminator, scratch_);
+    }
+    /// skips a declaration, such as DOCTYPE, with its internal subset
+    void skip_declaration() {
+        int depth = 0;
+        for(auto c = get(); c != '>' || depth != 0; c = get()) {
+            if (c == eof) fail("declaration is not closed");
+            if (c == '[') ++depth;
+            if (c == ']') --depth;
+        }
+    }
+    void entity(std::string& into) {
+        std::string name {};
+        for(auto c = get(); c != ';'; c = get()) {
+            if (c == eof || name.size() > 8) fail("malformed entity");
+            name.push_back(static_cast<char>(c));
+        }
+        if (name == "amp") into.push_back('&');
+        else if (name == "lt") into.push_back('<');
+        else if (name == "gt") into.push_back('>');
+        else if (name == "quot") into.push_back('"');
+        else if (name == "apos") into.push_back('\'');
+        else if (name.starts_with('#')) character(name, into);
+        else fail(std::format("unknown entity &{};", name));
+    }
+    /// appends a character reference, encoded in UTF-8
+    void character(std::string_view reference, std::string& into) {
+        const bool hex = reference.starts_with("#x");
+        const auto digits = reference.substr(hex ? 2 : 1);
+        std::uint32_t code = 0;
+        for(const auto c : digits) {
+            const auto digit = static_cast<unsigned char>(c);
+            if (! (hex ? std::isxdigit(digit) : std::isdigit(digit)))
+                fail(std::format("malformed character reference &{};", reference));
+            code = code * (hex ? 16U : 10U) + static_cast<std::uint32_t>(std::isdigit(digit) ? digit - '0' : (digit | 0x20) - 'a' + 10);
+        }
+        const auto put = [&into](std::uint32_t value) { into.push_back(static_cast<char>(value)); };
+        if (code < 0x80) {
+            put(code);
+        } else if (code < 0x800) {
+            put(0xC0 | (code >> 6));
+            put(0x80 | (code & 0x3F));
+        } else if (code < 0x10000) {
+            put(0xE0 | (code >> 12));
+            put(0x80 | ((code >> 6) & 0x3F));
+            put(0x80 | (code & 0x3F));
+        } else {
+            put(0xF0 | (code >> 18));
+            put(0x80 | ((code >> 12) & 0x3F));
+            put(0x80 | ((code >> 6) & 0x3F));
+            put(0x80 | (code & 0x3F));
+        }
+    }
+    void read_attributes() {
+        attributes_.clear();
+        for(;;) {
+            skip_spaces();
+            const auto c = peek();
+            if (c == '>' || c == '/' || c == eof) return;
+            attribute item {};
+            read_name(item.name);
+            skip_spaces();
+            expect('=');
+            skip_spaces();
+            const auto quote = get();
+            if (quote != '"' && quote != '\'') fail("quoted attribute value is expected");
+            for(auto v = get(); v != quote; v = get()) {
+                if (v == eof) fail("attribute value is not closed");
+                if (v == '&') entity(item.value);
+                else item.value.push_back(static_cast<char>(v));
+            }
+            attributes_.push_back(std::move(item));
+        }
+    }
+    template<typename Handler>
+    void markup(Handler& handler, std::string& text) {
+        const auto c = get();
+        if (c == '?') {
+            skip_past("?>");
+        } else if (c == '!') {
+            if (peek() == '-') {
+                get();
+                expect('-');
+                skip_past("-->");
+            } else if (peek() == '[') {
+                for(const auto expected : std::string_view{"[CDATA["}) expect(expected);
+                read_past("]]>", text);
+            } else {
+                skip_declaration();
+            }
+        } else if (c == '/') {
+            read_name(name_);
+            skip_spaces();
+            expect('>');
+            if (open_.empty() || open_.back() != name_)
+                fail(std::format("unexpected closing element {}", name_));
+            open_.pop_back();
+            handler.close();
+        } else {
+            if (c == eof) fail("unexpected end of stream");
+            name_.assign(1, static_cast<char>(c));
+            while(name_char(peek())) name_.push_back(static_cast<char>(get()));
+            read_attributes();
+            const bool empty = peek() == '/';
+            if (empty) get();
+            expect('>');
+            handler.open(name_, attributes_);
+            if (empty) handler.close();
+            else open_.push_back(name_);
+        }
+    }
+    std::istream& stream_;
+    std::vector<char> buffer_;
+    std::size_t position_ {};
+    std::size_t size_ {};
+    std::size_t line_ { 1 };
+    std::vector<std::string> open_ {};
+    std::string name_ {};
+    std::string scratch_ {};
+    attributes attributes_ {};
+};
+
+/// register properties, inherited from the enclosing element when not specified
+struct properties {
+    std::optional<std::uint64_t> size {};
+    std::optional<std::uint64_t> reset_value {};
+    std::optional<std::uint64_t> reset_mask {};
+    std::optional<access_type> access {};
+    void inherit(const properties& from) {
+        if (! size) size = from.size;
+        if (! reset_value) reset_value = from.reset_value;
+        if (! reset_mask) reset_mask = from.reset_mask;
+        if (! access) access = from.access;
+    }
+};
+
+/// element of the device description - the device, a peripheral, a cluster or a register
+struct node {
+    enum class kind_type : std::uint8_t { device, peripheral, cluster, reg };
+    kind_type kind {};
+    std::string name {};
+    std::string derived_from {};
+    std::optional<std::uint64_t> offset {}; ///< base address of a peripheral, address offset of a cluster or a register
+    properties props {};
+    std::uint64_t dim {};
+    std::uint64_t dim_increment {};
+    std::string dim_index {};
+    bool alternate {};
+    std::vector<node> children {};
+};
+
+std::string_view trim(std::string_view text) noexcept {
+    const auto begin = text.find_first_not_of(" \t\r\n");
+    if (begin == std::string_view::npos) return {};
+    return text.substr(begin, text.find_last_not_of(" \t\r\n") - begin + 1);
+}
+
+/// parses scaledNonNegativeInteger: decimal, 0x hexadecimal or # binary, with an optional k, M, G or T scale
+std::uint64_t number(std::string_view text, std::string_view what) {
+    const auto value = trim(text);
+    const auto malformed = [&] { return bad_svd_format{std::format("malformed number '{}' in {}", value, what)}; };
+    std::uint64_t base = 10;
+    auto digits = value.starts_with('+') ? value.substr(1) : value;
+    if (digits.starts_with("0x") || digits.starts_with("0X")) {
+        base = 16;
+        digits.remove_prefix(2);
+    } else if (digits.starts_with('#')) {
+        base = 2;
+        digits.remove_prefix(1);
+    }
+    std::uint64_t scale = 1;
+    if (base != 16 && ! digits.empty()) {
+        switch(digits.back()) {
+        case 'k': case 'K': scale = std::uint64_t{1} << 10; break;
+        case 'm': case 'M': scale = std::uint64_t{1} << 20; break;
+        case 'g': case 'G': scale = std::uint64_t{1} << 30; break;
+        case 't': case 'T': scale = std::uint64_t{1} << 40; break;
+        default: break;
+        }
+        if (scale != 1) digits.remove_suffix(1);
+    }
+    if (digits.empty()) throw malformed();
+    std::uint64_t result = 0;
+    for(const auto c : digits) {
+        std::uint64_t digit = 0;
+        if (base == 2 && (c == 'x' || c == 'X')) digit = 0; // don't care bit
+        else if (c >= '0' && c <= '9') digit = static_cast<std::uint64_t>(c - '0');
+        else if (base == 16 && c >= 'a' && c <= 'f') digit = static_cast<std::uint64_t>(c - 'a' + 10);
+        else if (base == 16 && c >= 'A' && c <= 'F') digit = static_cast<std::uint64_t>(c - 'A' + 10);
+        else throw malformed();
+        if (digit >= base) throw malformed();
+        result = result * base + digit;
+    }
+    return result * scale;
+}
+
+access_type access(std::string_view text, std::string_view what) {
+    const auto value = trim(text);
+    if (value == "read-write") return access_type::read_write;
+    if (value == "read-only") return access_type::read_only;
+    if (value == "write-only") return access_type::write_only;
+    if (value == "writeOnce") return access_type::write_once;
+    if (value == "read-writeOnce") return access_type::read_write_once;
+    throw bad_svd_format{std::format("unknown access '{}' in {}", value, what)};
+}
+
+/// builder - builds the device tree from the elements, passed by the reader,
+/// keeping only the properties, relevant to the register layout
+class builder {
+public:
+    void open(std::string_view name, const attributes& attrs) {
+        if (frames_.empty()) {
+            if (name != "device") throw bad_svd_format{std::format("root element {} is not a device", name)};
+            frames_.push_back({ frame_kind::item, &device_, {} });
+            return;
+        }
+        const auto& parent = frames_.back();
+        auto& owner = *parent.item;
+        switch(parent.kind) {
+        case frame_kind::item:
+            if (owner.kind == node::kind_type::device && name == "peripherals") {
+                frames_.push_back({ frame_kind::list, &owner, {} });
+            } else if (owner.kind == node::kind_type::peripheral && name == "registers") {
+                frames_.push_back({ frame_kind::list, &owner, {} });
+            } else if (owner.kind == node::kind_type::cluster && (name == "register" || name == "cluster")) {
+                frames_.push_back({ frame_kind::item, &add(owner, name, attrs), {} });
+            } else {
+                text_.clear();
+                frames_.push_back({ frame_kind::property, &owner, std::string{name} });
+            }
+            break;
+        case frame_kind::list:
+            if (owner.kind == node::kind_type::device ? name == "peripheral" : (name == "register" || name == "cluster"))
+                frames_.push_back({ frame_kind::item, &add(owner, name, attrs), {} });
+            else
+                frames_.push_back({ frame_kind::ignored, &owner, {} });
+            break;
+        case frame_kind::property:
+        case frame_kind::ignored:
+        default:
+            frames_.push_back({ frame_kind::ignored, &owner, {} });
+            break;
+        }
+    }
+    void text(std::string_view value) {
+        if (frames_.back().kind == frame_kind::property) text_ += value;
+    }
+    void close() {
+        const auto& top = frames_.back();
+        if (top.kind == frame_kind::property) assign(*top.item, top.name);
+        frames_.pop_back();
+    }
+    const node& device() const noexcept { return device_; }
+private:
+    enum class frame_kind : std::uint8_t { item, list, property, ignored };
+    struct frame {
+        frame_kind kind;
+        node* item;
+        std::string name;
+    };
+    /// adds a child to the node, an open node is always the last child of its parent, so pointers to open nodes stay valid
+    static node& add(node& owner, std::string_view name, const attributes& attrs) {
+        auto& item = owner.children.emplace_back();
+        item.kind = name == "peripheral" ? node::kind_type::peripheral
+                  : name == "cluster" ? node::kind_type::cluster : node::kind_type::reg;
+        for(const auto& attr : attrs)
+            if (attr.name == "derivedFrom") item.derived_from = trim(attr.value);
+        return item;
+    }
+    void assign(node& item, std::string_view property) {
+        const auto value = trim(text_);
+        if (property == "name") item.name = value;
+        else if (property == "baseAddress" || property == "addressOffset") item.offset = number(value, property);
+        else if (property == "size") item.props.size = number(value, property);
+        else if (property == "resetValue") item.props.reset_value = number(value, property);
+        else if (property == "resetMask") item.props.reset_mask = number(value, property);
+        else if (property == "access") item.props.access = access(value, property);
+        else if (property == "dim") item.dim = number(value, property);
+        else if (property == "dimIncrement") item.dim_increment = number(value, property);
+        else if (property == "dimIndex") item.dim_index = value;
+        else if (property == "alternateRegister" || property == "alternateGroup") item.alternate = true;
+    }
+    node device_ { node::kind_type::device };
+    std::vector<frame> frames_ {};
+    std::string text_ {};
+};
+
+/// expands dimIndex of an element into the list of indices
+std::vector<std::string> indices(const node& item) {
+    std::vector<std::string> result {};
+    const auto list = trim(item.dim_index);
+    if (list.empty()) {
+        for(std::uint64_t i = 0; i < item.dim; ++i) result.push_back(std::to_string(i));
+    } else if (const auto dash = list.find('-'); dash != std::string_view::npos && list.find(',') == std::string_view::npos) {
+        const auto first = trim(list.substr(0, dash));
+        const auto last = trim(list.substr(dash + 1));
+        if (first.size() == 1 && last.size() == 1 && std::isalpha(first[0]) && std::isalpha(last[0])) {
+            for(auto c = first[0]; c <= last[0]; ++c) result.emplace_back(1, c);
+        } else {
+            for(auto i = number(first, "dimIndex"), end = number(last, "dimIndex"); i <= end; ++i)
+                result.push_back(std::to_string(i));
+        }
+    } else {
+        for(std::size_t begin = 0; begin <= list.size();) {
+            const auto end = std::min(list.find(',', begin), list.size());
+            result.emplace_back(trim(list.substr(begin, end - begin)));
+            begin = end + 1;
+        }
+    }
+    if (result.size() != item.dim)
+        throw bad_svd_format{std::format("dimIndex of {} does not match its dim {}", item.name, item.dim)};
+    return result;
+}
+
+std::string instance_name(std::string_view name, std::string_view index) {
+    std::string result { name };
+    if (const auto pos = result.find("%s"); pos != std::string::npos) result.replace(pos, 2, index);
+    return result;
+}
+
+/// table_builder - expands the device tree into the register table
+class table_builder {
+public:
+    explicit table_builder(const node& device) : device_ { device } {}
+    std::vector<std::byte> build() {
+        const auto device_name = intern(device_.name);
+        for(const auto& item : device_.children) peripheral(item, 0);
+        table_header header {};
+        header.peripheral_count = static_cast<std::uint32_t>(peripherals_.size());
+        header.register_count = static_cast<std::uint32_t>(registers_.size());
+        header.strings_size = static_cast<std::uint32_t>(strings_.size());
+        header.name = device_name;
+        std::vector<std::byte> image(sizeof(header) + sizeof(peripheral_entry) * peripherals_.size() +
+                                     sizeof(register_entry) * registers_.size() + strings_.size());
+        auto* output = image.data();
+        const auto put = [&output](const void* data, std::size_t size) {
+            if (size != 0) std::memcpy(output, data, size);
+            output += size;
+        };
+        put(&header, sizeof(header));
+        put(peripherals_.data(), sizeof(peripheral_entry) * peripherals_.size());
+        put(registers_.data(), sizeof(register_entry) * registers_.size());
+        put(strings_.data(), strings_.size());
+        return image;
+    }
+private:
+    static constexpr int max_derivation_depth = 16;
+    struct found {
+        const node* item;
+        std::span<const node> scope;
+    };
+    std::uint32_t intern(std::string_view name) {
+        if (const auto pos = interned_.find(std::string{name}); pos != interned_.end()) return pos->second;
+        const auto offset = static_cast<std::uint32_t>(strings_.size());
+        strings_.append(name);
+        strings_.push_back('\0');
+        interned_.emplace(name, offset);
+        return offset;
+    }
+    static const node* named(std::span<const node> scope, std::string_view name) noexcept {
+        const auto pos = std::ranges::find(scope, name, &node::name);
+        return pos == scope.end() ? nullptr : &*pos;
+    }
+    /// finds the element, named by a derivedFrom path, either in the scope or starting from peripherals of the device
+    found lookup(std::span<const node> scope, std::string_view path) const {
+        if (const auto* item = named(scope, path)) return { item, scope };
+        std::span<const node> current { device_.children };
+        const node* item = nullptr;
+        for(std::size_t begin = 0; begin <= path.size();) {
+            const auto end = std::min(path.find('.', begin), path.size());
+            item = named(current, path.substr(begin, end - begin));
+            if (item == nullptr) break;
+            if (end != path.size()) current = item->children;
+            begin = end + 1;
+        }
+        if (item == nullptr) throw bad_svd_format{std::format("derivedFrom {} is not found", path)};
+        return { item, current };
+    }
+    /// merges the derived element with the element it is derived from
+    node derive(const node& item, std::span<const node> scope, int depth) const {
+        if (depth > max_derivation_depth)
+            throw bad_svd_format{std::format("derivedFrom of {} is too deep or circular", item.name)};
+        const auto base = lookup(scope, item.derived_from);
+        node result = base.item->derived_from.empty() ? *base.item : derive(*base.item, base.scope, depth + 1);
+        result.name = item.name;
+        result.derived_from.clear();
+        if (item.offset) result.offset = item.offset;
+        properties props = item.props;
+        props.inherit(result.props);
+        result.props = props;
+        if (item.dim != 0) {
+            result.dim = item.dim;
+            result.dim_increment = item.dim_increment;
+            result.dim_index = item.dim_index;
+        }
+        if (! item.children.empty()) result.children = item.children;
+        result.alternate = item.alternate;
+        return result;
+    }
+    /// calls function for each instance of a dim array element with its name and offset
+    template<typename Function>
+    static void instances(const node& item, Function&& function) {
+        if (item.dim == 0) {
+            function(std::string{item.name}, std::uint64_t{0});
+            return;
+        }
+        const auto list = indices(item);
+        for(std::size_t i = 0; i < list.size(); ++i)
+            function(instance_name(item.name, list[i]), i * item.dim_increment);
+    }
+    void peripheral(const node& item, int depth) {
+        if (! item.derived_from.empty()) {
+            peripheral(derive(item, device_.children, depth), depth + 1);
+            return;
+        }
+        if (! item.offset) throw bad_svd_format{std::format("peripheral {} has no baseAddress", item.name)};
+        properties props = item.props;
+        props.inherit(device_.props);
+        instances(item, [&](std::string name, std::uint64_t offset) {
+            peripheral_entry entry { *item.offset + offset, intern(name), static_cast<std::uint32_t>(registers_.size()), 0, 0 };
+            children(item.children, entry.address, {}, props);
+            const auto first = registers_.begin() + entry.first;
+            std::ranges::stable_sort(first, registers_.end(), {}, &register_entry::address);
+            entry.count = static_cast<std::uint32_t>(registers_.size() - entry.first);
+            peripherals_.push_back(entry);
+        });
+    }
+    void children(std::span<const node> scope, std::uint64_t base, const std::string& prefix, const properties& inherited) {
+        for(const auto& item : scope) child(item, scope, base, prefix, inherited, 0);
+    }
+    void child(const node& item, std::span<const node> scope, std::uint64_t base, const std::string& prefix,
+               const properties& inherited, int depth) {
+        if (! item.derived_from.empty()) {
+            child(derive(item, scope, depth), scope, base, prefix, inherited, depth + 1);
+            return;
+        }
+        if (item.alternate) return;
+        if (! item.offset) throw bad_svd_format{std::format("{}{} has no addressOffset", prefix, item.name)};
+        properties props = item.props;
+        props.inherit(inherited);
+        instances(item, [&](std::string name, std::uint64_t offset) {
+            const auto address = base + *item.offset + offset;
+            if (item.kind == node::kind_type::cluster)
+                children(item.children, address, prefix + name + ".", props);
+            else
+                add(address, prefix + name, props);
+        });
+    }
+    void add(std::uint64_t address, std::string_view name, const properties& props) {
+        const auto bits = props.size.value_or(32);
+        if (bits == 0 || bits > 64)
+            throw bad_svd_format{std::format("register {} has unsupported size {}", name, bits)};
+        const auto mask = bits == 64 ? ~std::uint64_t{} : (std::uint64_t{1} << bits) - 1;
+        registers_.push_back({ address, props.reset_value.value_or(0) & props.reset_mask.value_or(mask) & mask,
+            intern(name), static_cast<std::uint8_t>((bits + 7) / 8), props.access.value_or(access_type::read_write), 0 });
+    }
+    const node& device_;
+    std::vector<peripheral_entry> peripherals_ {};
+    std::vector<register_entry> registers_ {};
+    std::string strings_ {};
+    std::unordered_map<std::string, std::uint32_t> interned_ {};
+};
+
+std::vector<std::byte> build(std::istream& stream) {
+    builder tree {};
+    reader { stream }.run(tree);
+    return table_builder { tree.device() }.build();
+}
+
+} // namespace
+
+device::device(std::vector<std::byte> image) : image_ { std::move(image) } {
+    bind(image_);
+}
+
+device::device(void* mapping, std::size_t size) : mapping_ { mapping }, mapping_size_ { size } {
+    try {
+        bind({ static_cast<const std::byte*>(mapping), size });
+    } catch(...) {
+        munmap(mapping_, mapping_size_);
+        throw;
+    }
+}
+
+device::device(device&& that) noexcept
+  : image_ { std::move(that.image_) }, mapping_ { std::exchange(that.mapping_, nullptr) },
+    mapping_size_ { std::exchange(that.mapping_size_, 0) }, header_ { std::exchange(that.header_, nullptr) },
+    peripherals_ { std::exchange(that.peripherals_, {}) }, registers_ { std::exchange(that.registers_, {}) },
+    strings_ { std::exchange(that.strings_, {}) } {}
+
+device& device::operator=(device&& that) noexcept {
+    if (this == &that) return *this;
+    if (mapping_ != nullptr) munmap(mapping_, mapping_size_);
+    image_ = std::move(that.image_);
+    mapping_ = std::exchange(that.mapping_, nullptr);
+    mapping_size_ = std::exchange(that.mapping_size_, 0);
+    header_ = std::exchange(that.header_, nullptr);
+    peripherals_ = std::exchange(that.peripherals_, {});
+    registers_ = std::exchange(that.registers_, {});
+    strings_ = std::exchange(that.strings_, {});
+    return *this;
+}
+
+device::~device() {
+    if (mapping_ != nullptr) munmap(mapping_, mapping_size_);
+}
+
+void device::bind(std::span<const std::byte> image) {
+    const auto* header = reinterpret_cast<const table_header*>(image.data());
+    if (image.size() < sizeof(table_header) || header->magic != table_header::signature)
+        throw bad_svd_format{"image is not a stubmmio register table"};
+    if (header->version != table_header::current || header->entry_size != sizeof(register_entry)) {
+        throw bad_svd_format{std::format("unsupported register table version {} with entry size {}",
+            header->version, header->entry_size)};
+    }
+    const auto size = sizeof(table_header) + sizeof(peripheral_entry) * std::uint64_t{header->peripheral_count} +
+                      sizeof(register_entry) * std::uint64_t{header->register_count} + header->strings_size;
+    if (size != image.size() || header->strings_size == 0)
+        throw bad_svd_format{std::format("register table is truncated or corrupted, size {} of {}", image.size(), size)};
+    const auto* peripherals = reinterpret_cast<const peripheral_entry*>(header + 1);
+    const auto* registers = reinterpret_cast<const register_entry*>(peripherals + header->peripheral_count);
+    const auto* strings = reinterpret_cast<const char*>(registers + header->register_count);
+    if (strings[header->strings_size - 1] != '\0')
+        throw bad_svd_format{"register table string pool is not terminated"};
+    header_ = header;
+    peripherals_ = { peripherals, header->peripheral_count };
+    registers_ = { registers, header->register_count };
+    strings_ = { strings, header->strings_size };
+    const auto bad = [this](std::uint32_t offset) noexcept { return offset >= strings_.size(); };
+    const auto bad_peripheral = [&](const peripheral_entry& item) noexcept {
+        return bad(item.name) || item.first > registers_.size() || item.count > registers_.size() - item.first;
+    };
+    if (bad(header->name) || std::ranges::any_of(peripherals_, bad_peripheral) ||
+        std::ranges::any_of(registers_, bad, &register_entry::name)) {
+        throw bad_svd_format{"register table has entries out of range"};
+    }
+}
+
+device device::parse(std::istream& stream) {
+    return device { build(stream) };
+}
+
+device device::map(const std::filesystem::path& table) {
+    const int fd = open(table.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        const auto err = errno;
+        throw std::system_error{{err, std::system_category()}, std::format("open {} has failed", table.string())};
+    }
+    struct stat status {};
+    void* mapping = MAP_FAILED;
+    if (fstat(fd, &status) == 0 && status.st_size > 0)
+        mapping = mmap(nullptr, static_cast<std::size_t>(status.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+    const auto err = errno;
+    close(fd);
+    if (mapping == MAP_FAILED) {
+        if (status.st_size == 0) throw bad_svd_format{std::format("register table {} is empty", table.string())};
+        throw std::system_error{{err, std::system_category()}, std::format("mmap {} has failed", table.string())};
+    }
+    return device { mapping, static_cast<std::size_t>(status.st_size) };
+}
+
+device device::load(const std::filesystem::path& svd, const std::filesystem::path& table) {
+    const auto source_size = std::filesystem::file_size(svd);
+    const auto source_time = static_cast<std::int64_t>(std::filesystem::last_write_time(svd).time_since_epoch().count());
+    std::error_code error {};
+    if (std::filesystem::exists(table, error)) {
+        try {
+            auto result = map(table);
+            if (result.header_->source_size == source_size && result.header_->source_time == source_time)
+                return result;
+            log::info{}.format("Register table {} is stale, rebuilding", table.string());
+        } catch(const std::exception& failure) {
+            log::warning{}.format("Register table {} is not usable, rebuilding: {}", table.string(), failure.what());
+        }
+    }
+    std::ifstream stream { svd, std::ios::binary };
+    if (! stream) throw bad_svd_format{std::format("{} cannot be opened", svd.string())};
+    auto image = build(stream);
+    auto* header = reinterpret_cast<table_header*>(image.data());
+    header->source_size = source_size;
+    header->source_time = source_time;
+    device result { std::move(image) };
+    // written aside and renamed, so that concurrent loaders never map a partially written table
+    auto temporary = table;
+    temporary += std::format(".{}", getpid());
+    {
+        std::ofstream file { temporary, std::ios::binary | std::ios::trunc };
+        result.save(file);
+        file.close();
+        if (! file) error = std::make_error_code(std::errc::io_error);
+    }
+    if (! error) std::filesystem::rename(temporary, table, error);
+    if (error) {
+        log::warning{}.format("Register table {} cannot be saved: {}", table.string(), error.message());
+        std::filesystem::remove(temporary, error);
+    }
+    return result;
+}
+
+void device::save(std::ostream& stream) const {
+    const auto size = sizeof(table_header) + peripherals_.size_bytes() + registers_.size_bytes() + strings_.size();
+    stream.write(reinterpret_cast<const char*>(header_), static_cast<std::streamsize>(size));
+}
+
+const peripheral_entry* device::find(std::string_view peripheral) const noexcept {
+    const auto pos = std::ranges::find_if(peripherals_, [&](const auto& item) noexcept { return name(item) == peripheral; });
+    return pos == peripherals_.end() ? nullptr : &*pos;
+}
+
+const register_entry* device::find(std::string_view peripheral, std::string_view register_name) const noexcept {
+    const auto* owner = find(peripheral);
+    if (owner == nullptr) return nullptr;
+    const auto list = registers(*owner);
+    const auto pos = std::ranges::find_if(list, [&](const auto& item) noexcept { return name(item) == register_name; });
+    return pos == list.end() ? nullptr : &*pos;
+}
+
+stub device::on_reset(std::span<const std::string_view> names, std::source_location location) const {
+    std::vector<const register_entry*> selected {};
+    for(const auto peripheral : names) {
+        const auto* item = find(peripheral);
+        if (item == nullptr) {
+            throw exceptions::unknown_peripheral{std::format("Peripheral {} is not found in device {}, requested at {}:{}",
+                peripheral, name(), location.file_name(), location.line())};
+        }
+        for(const auto& entry : registers(*item)) selected.push_back(&entry);
+    }
+    return on_reset(std::move(selected), location);
+}
+
+stub device::on_reset(std::source_location location) const {
+    std::vector<const register_entry*> selected {};
+    selected.reserve(registers_.size());
+    for(const auto& entry : registers_) selected.push_back(&entry);
+    return on_reset(std::move(selected), location);
+}
+
+stub device::on_reset(std::vector<const register_entry*> selected, std::source_location location) const {
+    std::ranges::stable_sort(selected, {}, &register_entry::address);
+    stub::elements_type elements {};
+    std::uint64_t end = 0;
+    for(const auto* entry : selected) {
+        // alternate peripherals and registers, not marked as such, share addresses, the first one is kept
+        if (entry->address < end) {
+            log::debug{}.format("Register {} at {:X} overlaps the previous one and is skipped", name(*entry), entry->address);
+            continue;
+        }
+        end = entry->address + entry->size;
+        elements.try_emplace(elements.end(), entry->address,
+            region { static_cast<region::address_type>(entry->address), entry->size },
+            [value = entry->reset_value](void* begin, void* finish) noexcept {
+                const auto size = static_cast<std::size_t>(static_cast<std::byte*>(finish) - static_cast<std::byte*>(begin));
+                std::memcpy(begin, &value, std::min(size, sizeof(value)));
+            }, location);
+    }
+    return stub(std::move(elements), location);
+}
+
+} // namespace stubmmio::svd
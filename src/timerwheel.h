@@ -0,0 +1,118 @@
+/*
+ * Copyright (C) 2025 Eugene Hutorny <eugene@hutorny.in.ua>
+ *
+ * src/timerwheel.h - hierarchical timer wheel
+ *
+ * Licensed under MIT License, see full text in LICENSE
+ * or visit page https://opensource.org/license/mit/
+ */
+
+#pragma once
+#include <array>
+#include <bit>
+#include <cstdint>
+#include <optional>
+#include <utility>
+#include <vector>
+
+namespace stubmmio::detail {
+
+/// hierarchical timer wheel of 64-slot levels, covering the entire 64-bit range of ticks
+/// an item is placed at the level of the highest 6-bit digit, in which its expiry differs from now,
+/// so that scheduling is O(1), and advancing is O(1) per level cascade and per expired item
+template<typename Item>
+class timerwheel {
+public:
+    using tick_type = std::uint64_t;
+    explicit timerwheel(tick_type now = 0) noexcept : now_ { now } {}
+
+    auto now() const noexcept { return now_; }
+    auto size() const noexcept { return size_; }
+    auto empty() const noexcept { return size_ == 0; }
+
+    /// schedules the item, an item expired already is due on next advance
+    void schedule(tick_type expiry, Item item) {
+        ++size_;
+        if (expiry <= now_)
+            due_.push_back({ expiry, std::move(item) });
+        else
+            place({ expiry, std::move(item) });
+    }
+    /// advances the wheel to the given tick, calling expired(item) for every item expired, in order of expiry
+    template<typename Expired>
+    void advance(tick_type to, Expired&& expired) {
+        for(;;) {
+            if (! due_.empty()) {
+                // expired may schedule more items
+                fire(std::exchange(due_, {}), expired);
+                continue;
+            }
+            const auto next = next_event();
+            if (! next || *next > to) break;
+            now_ = *next;
+            // the event is at the lowest non-zero digit of now, items there are expired or cascade to lower levels
+            const auto level = static_cast<unsigned>(std::countr_zero(now_)) / bits;
+            const auto digit = digit_of(now_, level);
+            auto items = std::exchange(slots_[level][digit], {});
+            occupied_[level] &= ~(1ULL << digit);
+            for(auto& value : items) {
+                if (value.expiry == now_)
+                    due_.push_back(std::move(value));
+                else
+                    place(std::move(value));
+            }
+        }
+        if (now_ < to) now_ = to;
+    }
+    /// returns the tick of the next event, not later than the earliest expiry
+    std::optional<tick_type> next_event() const noexcept {
+        if (! due_.empty()) return now_;
+        for(unsigned level = 0; level < levels; ++level) {
+            const auto current = digit_of(now_, level);
+            const auto above = current == slots - 1 ? 0 : occupied_[level] & (~0ULL << (current + 1));
+            if (above == 0) continue;
+            const auto shift = level * bits;
+            const auto prefix = shift + bits >= 64 ? 0 : now_ >> (shift + bits) << (shift + bits);
+            return prefix | static_cast<tick_type>(std::countr_zero(above)) << shift;
+        }
+        return std::nullopt;
+    }
+    /// drops all items
+    void clear() noexcept {
+        for(auto& level : slots_)
+            for(auto& slot : level) slot.clear();
+        occupied_ = {};
+        due_.clear();
+        size_ = 0;
+    }
+private:
+    static constexpr unsigned bits = 6;
+    static constexpr unsigned slots = 1U << bits;
+    static constexpr unsigned levels = (64 + bits - 1) / bits;
+    struct entry {
+        tick_type expiry;
+        Item item;
+    };
+    static unsigned digit_of(tick_type tick, unsigned level) noexcept {
+        return static_cast<unsigned>(tick >> (level * bits)) & (slots - 1);
+    }
+    void place(entry&& value) {
+        const auto level = static_cast<unsigned>(std::bit_width(value.expiry ^ now_) - 1) / bits;
+        const auto digit = digit_of(value.expiry, level);
+        slots_[level][digit].push_back(std::move(value));
+        occupied_[level] |= 1ULL << digit;
+    }
+    template<typename Expired>
+    void fire(std::vector<entry>&& items, Expired& expired) {
+        size_ -= items.size();
+        for(auto& value : items)
+            expired(std::move(value.item));
+    }
+    std::array<std::array<std::vector<entry>, slots>, levels> slots_ {};
+    std::array<std::uint64_t, levels> occupied_ {};
+    std::vector<entry> due_ {};
+    tick_type now_;
+    std::size_t size_ {};
+};
+
+} // namespace stubmmio::detail
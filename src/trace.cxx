@@ -0,0 +1,202 @@
+/*
+ * Copyright (C) 2025 Eugene Hutorny <eugene@hutorny.in.ua>
+ *
+ * src/trace.cxx - access trace recorder implementation
+ *
+ * Licensed under MIT License, see full text in LICENSE
+ * or visit page https://opensource.org/license/mit/
+ */
+
+#include <stubmmio/trace.h>
+#include <stubmmio/logger.h>
+
+#include "mmio.h"
+#include "trap.h"
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <chrono>
+#include <format>
+#include <istream>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <utility>
+#include <vector>
+
+namespace stubmmio::trace {
+namespace {
+using log = logovod::logger<logcategory::trace>;
+
+/// ring - single producer, single consumer ring buffer of records.
+/// It is written only by its thread and read only by collect(), a record not fitting is dropped and counted
+class ring {
+public:
+    ring(std::size_t capacity, std::uint16_t thread) : records_(capacity), mask_ { capacity - 1 }, thread_ { thread } {}
+    void push(record item) noexcept {
+        const auto head = head_.load(std::memory_order_relaxed);
+        if (head - tail_.load(std::memory_order_acquire) > mask_) {
+            dropped_.store(dropped_.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+            return;
+        }
+        item.thread = thread_;
+        records_[head & mask_] = item;
+        head_.store(head + 1, std::memory_order_release);
+    }
+    void drain(std::vector<record>& into) {
+        const auto tail = tail_.load(std::memory_order_relaxed);
+        const auto head = head_.load(std::memory_order_acquire);
+        for(auto i = tail; i != head; ++i) into.push_back(records_[i & mask_]);
+        tail_.store(head, std::memory_order_release);
+    }
+    auto dropped() const noexcept { return dropped_.load(std::memory_order_relaxed); }
+private:
+    std::vector<record> records_;
+    std::uint64_t mask_;
+    std::uint16_t thread_;
+    alignas(64) std::atomic<std::uint64_t> head_ {};
+    std::atomic<std::uint64_t> dropped_ {};
+    alignas(64) std::atomic<std::uint64_t> tail_ {};
+};
+
+/// incremented on start, so that threads attach new ring buffers
+constinit std::atomic<std::uint64_t> generation_ {};
+
+/// recorder - registry of the ring buffers, a thread attaches its ring on its first record after start
+class recorder {
+public:
+    static recorder& instance() {
+        static recorder inst {};
+        return inst;
+    }
+    struct attachment {
+        std::shared_ptr<ring> buffer;
+        std::uint64_t generation;
+    };
+    void start(std::size_t capacity) {
+        std::lock_guard lock { mutex_ };
+        rings_.clear();
+        capacity_ = std::bit_ceil(std::max(capacity, std::size_t { 1 }));
+        generation_.store(generation_.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+        detail::enabled_.store(true, std::memory_order_release);
+    }
+    attachment attach() {
+        std::lock_guard lock { mutex_ };
+        const auto generation = generation_.load(std::memory_order_relaxed);
+        if (! detail::enabled_.load(std::memory_order_relaxed)) return { nullptr, generation };
+        rings_.push_back(std::make_shared<ring>(capacity_, static_cast<std::uint16_t>(rings_.size())));
+        return { rings_.back(), generation };
+    }
+    std::vector<record> collect() {
+        std::vector<record> result {};
+        std::lock_guard lock { mutex_ };
+        for(const auto& item : rings_) item->drain(result);
+        std::ranges::stable_sort(result, {}, &record::timestamp);
+        return result;
+    }
+    std::uint64_t dropped() {
+        std::lock_guard lock { mutex_ };
+        std::uint64_t result {};
+        for(const auto& item : rings_) result += item->dropped();
+        return result;
+    }
+private:
+    recorder() = default;
+    std::mutex mutex_ {};
+    std::vector<std::shared_ptr<ring>> rings_ {};
+    std::size_t capacity_ {};
+};
+
+/// the ring buffer of the thread is owned by attached, current and attached_generation are kept trivial for fast access
+thread_local recorder::attachment attached {};
+thread_local constinit ring* current {};
+thread_local constinit std::uint64_t attached_generation {};
+
+} // namespace
+
+void detail::append(const volatile void* address, std::uint8_t width, std::uint64_t value, kind_type kind) noexcept {
+    if (attached_generation != generation_.load(std::memory_order_acquire)) {
+        try {
+            attached = recorder::instance().attach();
+        } catch(const std::exception& error) {
+            log::error{}.format("Trace buffer allocation has failed: {}", error.what());
+            attached = { nullptr, generation_.load(std::memory_order_acquire) };
+        }
+        current = attached.buffer.get();
+        attached_generation = attached.generation;
+    }
+    if (current == nullptr) return;
+    const auto timestamp = std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+    current->push({ static_cast<std::uint64_t>(timestamp), value,
+        static_cast<std::uint32_t>(reinterpret_cast<std::uintptr_t>(address)), width, kind, 0 });
+}
+
+void start(std::size_t capacity) {
+    recorder::instance().start(capacity);
+}
+
+void stop() noexcept {
+    detail::enabled_.store(false, std::memory_order_release);
+}
+
+bool enabled() noexcept {
+    return detail::enabled_.load(std::memory_order_relaxed);
+}
+
+bool watch(region area) {
+    const stubmmio::detail::volatile_span addresses { area.begin<const volatile char>(), area.size() };
+    if (! stubmmio::detail::mmio::arena().contains(addresses)) {
+        throw exceptions::page_is_not_allocated{std::format(
+            "page is not allocated for traced region {}[{}]", area.begin(), area.size())};
+    }
+    return stubmmio::detail::trap_accesses(addresses, true);
+}
+
+void unwatch(region area) noexcept {
+    stubmmio::detail::trap_accesses({ area.begin<const volatile char>(), area.size() }, false);
+}
+
+std::vector<record> collect() {
+    return recorder::instance().collect();
+}
+
+std::uint64_t dropped() noexcept {
+    return recorder::instance().dropped();
+}
+
+void save(std::ostream& stream, std::span<const record> records) {
+    const file_header header {};
+    stream.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    stream.write(reinterpret_cast<const char*>(records.data()), static_cast<std::streamsize>(records.size_bytes()));
+}
+
+std::vector<record> load(std::istream& stream) {
+    file_header header {};
+    if (! stream.read(reinterpret_cast<char*>(&header), sizeof(header)) || header.magic != file_header::signature)
+        throw exceptions::bad_trace_format{"stream is not a stubmmio trace"};
+    if (header.version != file_header::current || header.record_size != sizeof(record)) {
+        throw exceptions::bad_trace_format{std::format("unsupported trace version {} with record size {}",
+            header.version, header.record_size)};
+    }
+    std::vector<record> result {};
+    record item {};
+    while(stream.read(reinterpret_cast<char*>(&item), sizeof(item)))
+        result.push_back(item);
+    if (stream.gcount() != 0)
+        throw exceptions::bad_trace_format{std::format("trace is truncated after {} records", result.size())};
+    return result;
+}
+
+std::string format(const record& item) {
+    const auto kind = item.kind == kind_type::write ? 'W' : 'R';
+    if (item.width == 0) {
+        return std::format("{:>16} {:>6} {} {:08X}  ? {:016X}",
+            item.timestamp, item.thread, kind, item.address, item.value);
+    }
+    return std::format("{:>16} {:>6} {} {:08X} {:2} {:0{}X}",
+        item.timestamp, item.thread, kind, item.address, item.width, item.value, item.width * 2);
+}
+
+} // namespace stubmmio::trace
@@ -0,0 +1,48 @@
+/*
+ * Copyright (C) 2025 Eugene Hutorny <eugene@hutorny.in.ua>
+ *
+ * src/trap.h - fault handling for trapped stimuli, traced, tracked and governed pages
+ *
+ * Licensed under MIT License, see full text in LICENSE
+ * or visit page https://opensource.org/license/mit/
+ */
+
+#pragma once
+#include <stubmmio/stubmmio.h>
+#include <stubmmio/semantics.h>
+#include <signal.h>
+#include <vector>
+
+namespace stubmmio::detail {
+
+/// handles SIGSEGV caused by a write to a trapped or tracked page or an access to a traced or governed one,
+/// returns false if the fault is not such
+bool handle_write_fault(siginfo_t* info, void* context) noexcept;
+
+/// returns true if accesses can be trapped on this platform
+bool traps_supported() noexcept;
+
+/// starts or stops enforcing semantics of the register on behalf of the owner, returns false if traps are not supported,
+/// throws duplicate_address if the register is governed by another rule
+bool govern_accesses(const semantics::rule&, const void* owner, bool on);
+
+/// starts or stops tracing accesses to pages of the span with traps, returns false if traps are not supported
+bool trap_accesses(volatile_span, bool on);
+
+/// starts tracking writes to pages of the span with write protection, or marks them not written, or stops tracking
+void trap_writes(volatile_span, bool on);
+
+/// returns contiguous ranges of tracked pages within the region, written since they were tracked
+std::vector<region> written_pages(region);
+
+/// returns true if any page of the region is written since it was tracked, or it is not tracked
+bool pages_written(region);
+
+/// forgets traced, tracked and governed pages of the span being deallocated
+void release_pages(volatile_span) noexcept;
+
+/// protects trapped, traced, tracked, governed and write watched pages of the span again, after they are mapped anew,
+/// stimuli, which pages cannot be write watched anymore, are polled instead
+void restore_pages(volatile_span);
+
+} // namespace stubmmio::detail
@@ -14,12 +14,14 @@
 #include <iostream>
 #include <errno.h>
 #include <cstring>
+#include "trap.h"
 
 namespace stubmmio::util {
 using namespace stubmmio::exceptions;
 using log = logovod::logger<logcategory::sigsegv>;
 
-static void sigsegv_action(int, siginfo_t * si, void*) {
+static void sigsegv_action(int, siginfo_t * si, void* context) {
+    if (detail::handle_write_fault(si, context)) return;
     auto msg = std::format("Access to unallocated address {}\n", si->si_addr);
     log::error{}(msg);
     throw access_to_unallocated_address(msg);
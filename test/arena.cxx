@@ -0,0 +1,346 @@
+/*
+ * Copyright (C) 2025 Eugene Hutorny <eugene@hutorny.in.ua>
+ *
+ * test/arena.cxx - unit tests for arena
+ *
+ * Licensed under MIT License, see full text in LICENSE
+ * or visit page https://opensource.org/license/mit/
+ */
+
+#include <stubmmio/stubmmio.h>
+#include <stubmmio/snapshot.h>
+#include <stubmmio/unit.h>
+#include <mmio.h>
+#include <optional>
+#include <thread>
+#include <vector>
+
+using namespace stubmmio;
+using namespace stubmmio::detail;
+
+namespace {
+using namespace boost::ut;
+using namespace boost::ut::bdd;
+using namespace boost::ut::literals;
+
+constexpr test::native_type initial = 0xA5A5A5A5U;
+constexpr test::native_type modified = 0x5A5A5A5AU;
+
+template<typename T = test::native_type>
+auto& at(std::uintptr_t addr) {
+    return *reinterpret_cast<volatile T*>(addr);
+}
+
+/// reserves arena for the scope of a test
+struct reserved_arena {
+    reserved_arena() { arena::reserve(); }
+    ~reserved_arena() { arena::release(onfail::logs); }
+    reserved_arena(const reserved_arena&) = delete;
+    reserved_arena(reserved_arena&&) = delete;
+    reserved_arena& operator=(const reserved_arena&) = delete;
+    reserved_arena& operator=(reserved_arena&&) = delete;
+};
+
+/// tracks written pages for the scope of a test
+struct tracked_writes {
+    tracked_writes() { arena::track_writes(); }
+    ~tracked_writes() { arena::track_writes(false); }
+    tracked_writes(const tracked_writes&) = delete;
+    tracked_writes(tracked_writes&&) = delete;
+    tracked_writes& operator=(const tracked_writes&) = delete;
+    tracked_writes& operator=(tracked_writes&&) = delete;
+};
+
+/// sets allocation policy for the scope of a test
+struct scoped_policy {
+    explicit scoped_policy(const arena::policy_type& policy) { arena::policy(policy); }
+    ~scoped_policy() { arena::policy({}); }
+    scoped_policy(const scoped_policy&) = delete;
+    scoped_policy(scoped_policy&&) = delete;
+    scoped_policy& operator=(const scoped_policy&) = delete;
+    scoped_policy& operator=(scoped_policy&&) = delete;
+};
+
+/// returns minor page faults taken by writing to each page of the region
+std::uint64_t faults_on_write(std::uintptr_t address, std::size_t pages) {
+    arena::reset_metrics();
+    for(std::size_t i = 0; i < pages; ++i) at(address + i * page_size) = modified;
+    return arena::metrics().minor_faults;
+}
+
+suite<"arena"> arena_suite = [] {
+    "reserve fails when pages are allocated"_test = [] {
+        stub setup {{address(0x50000), initial}};
+        setup();
+        expect(throws([] { arena::reserve(); }));
+        expect(!arena::reserve(onfail::returns));
+        expect(!arena::reserved());
+    };
+    "reserve and release"_test = [] {
+        expect(arena::reserve());
+        expect(arena::reserved());
+        expect(arena::release());
+        expect(!arena::reserved());
+    };
+    "release fails when pages are allocated"_test = [] {
+        reserved_arena reserved {};
+        stub setup {{address(0x50000), initial}};
+        setup();
+        expect(!arena::release(onfail::returns));
+        expect(arena::reserved());
+    };
+    "stub and verify in reserved arena"_test = [] {
+        reserved_arena reserved {};
+        stub setup {{address(0x50000), initial}, {address(0x52000), initial}};
+        setup();
+        expect(eq(arena::allocation_count(), 2U));
+        at(0x52004) = modified;
+        expect(verify {{address(0x50000), initial}, {address(0x52000), initial}, {address(0x52004), modified}}());
+    };
+    "deallocated pages are zeroed on next allocation"_test = [] {
+        reserved_arena reserved {};
+        {
+            stub setup {{address(0x50000), initial}, {address(0x50004), initial}};
+            setup();
+        }
+        expect(eq(arena::allocation_count(), 0U));
+        stub setup {{address(0x50000), initial}};
+        setup();
+        expect(at(0x50004) == 0U);
+    };
+    "snapshot in reserved arena"_test = [] {
+        reserved_arena reserved {};
+        {
+            stub setup {{address(0x50000), initial}};
+            setup();
+            const snapshot sut {};
+            at(0x50000) = modified;
+            sut.restore();
+            expect(at(0x50000) == initial);
+        }
+        stub setup {{address(0x50004), modified}};
+        setup();
+        expect(at(0x50000) == 0U);
+    };
+};
+
+suite<"arena writes"> arena_writes_suite = [] {
+    "applied pages are not written"_test = [] {
+        tracked_writes tracked {};
+        stub setup {{address(0x50000), initial}, {address(0x52000), initial}};
+        setup();
+        expect(arena::tracks_writes());
+        expect(arena::written().empty());
+        expect(! arena::written(region{ 0x50000, 4 }));
+        expect(at(0x50000) == initial);
+    };
+    "write marks its page written"_test = [] {
+        tracked_writes tracked {};
+        stub setup {{address(0x50000), initial}, {address(0x52000), initial}};
+        setup();
+        at(0x52004) = modified;
+        expect(at(0x52004) == modified);
+        expect(arena::written() == std::vector<region>{ region{ 0x52000, page_size } });
+        expect(arena::written(region{ 0x52000, 4 }));
+        expect(! arena::written(region{ 0x50000, 4 }));
+        arena::clean_writes();
+        expect(arena::written().empty());
+        at(0x52004) = initial;
+        expect(eq(arena::written().size(), 1U));
+    };
+    "writes are tracked on all threads"_test = [] {
+        tracked_writes tracked {};
+        stub setup {{address(0x50000), initial}, {address(0x51000), initial}};
+        setup();
+        std::thread writer { [] noexcept { at(0x51000) = modified; } };
+        writer.join();
+        expect(at(0x51000) == modified);
+        expect(arena::written() == std::vector<region>{ region{ 0x51000, page_size } });
+    };
+    "untracked pages count as written"_test = [] {
+        stub setup {{address(0x50000), initial}};
+        setup();
+        expect(arena::written(region{ 0x50000, 4 }));
+        expect(arena::written().empty());
+        tracked_writes tracked {};
+        expect(! arena::written(region{ 0x50000, 4 }));
+        expect(arena::written(region{ 0x60000, 4 }));
+    };
+    "deallocated pages are forgotten"_test = [] {
+        tracked_writes tracked {};
+        {
+            stub setup {{address(0x50000), initial}};
+            setup();
+            at(0x50000) = modified;
+            expect(eq(arena::written().size(), 1U));
+        }
+        expect(arena::written().empty());
+        stub setup {{address(0x50000), initial}};
+        setup();
+        at(0x50000) = modified;
+        expect(eq(arena::written().size(), 1U));
+    };
+    "restore discards written pages"_test = [] {
+        tracked_writes tracked {};
+        stub setup {{address(0x50000), initial}, {address(0x52000), initial}};
+        setup();
+        const snapshot sut {};
+        for(unsigned i = 0; i < 3; ++i) {
+            at(0x52000) = modified + i;
+            sut.restore();
+            expect(at(0x52000) == initial);
+            expect(at(0x50000) == initial);
+            expect(arena::written().empty());
+        }
+        at(0x50000) = modified;
+        arena::clean_writes();
+        sut.restore();
+        expect(at(0x50000) == initial);
+    };
+    "verify reports unverified writes"_test = [] {
+        tracked_writes tracked {};
+        stub setup {{address(0x50000), initial}, {address(0x51000), initial}, {address(0x52000), initial}};
+        setup();
+        const verify expected {{address(0x50000), modified}};
+        at(0x50000) = modified;
+        expect(expected());
+        expect(expected.unverified_writes().empty());
+        at(0x51ffc) = modified;
+        at(0x52000) = modified;
+        expect(expected.unverified_writes() == std::vector<region>{ region{ 0x51000, 2 * page_size } });
+    };
+};
+
+suite<"arena policy"> arena_policy_suite = [] {
+    constexpr std::size_t pages = 64;
+    "large ranges are populated"_test = [] {
+        scoped_policy policy {{ arena::prefault_type::populate, false, pages * page_size }};
+        const stub setup {{{0x50000, pages * page_size}}};
+        setup();
+        expect(lt(faults_on_write(0x50000, pages), pages / 2));
+    };
+    "large ranges are populated for write"_test = [] {
+        scoped_policy policy {{ arena::prefault_type::populate_write, false, pages * page_size }};
+        const stub setup {{{0x50000, pages * page_size}}};
+        setup();
+        expect(lt(faults_on_write(0x50000, pages), pages / 2));
+    };
+    "small ranges fault on access"_test = [] {
+        scoped_policy policy {{ arena::prefault_type::populate, false, pages * page_size }};
+        const stub setup {{{0x50000, pages / 2 * page_size}}};
+        setup();
+        expect(ge(faults_on_write(0x50000, pages / 2), pages / 2));
+    };
+    "reserved large ranges are populated and filled"_test = [] {
+        reserved_arena reserved {};
+        scoped_policy policy {{ arena::prefault_type::populate, true, pages * page_size }};
+        set_page_fill(initial);
+        const stub setup {{{0x50000, pages * page_size}}};
+        setup();
+        set_page_nofill();
+        expect(eq(at(0x50000 + (pages - 1) * page_size), initial));
+        expect(lt(faults_on_write(0x50000, pages), pages / 2));
+    };
+};
+
+suite<"arena fill template"> arena_fill_template_suite = [] {
+    // larger than a part of the template, 2 MiB
+    constexpr std::size_t pages = 600;
+    "mapped fill fills all pages"_test = [] {
+        arena::reset_metrics();
+        set_page_fill(initial, page_fill_type::mapped);
+        const stub setup {{{0x50000, pages * page_size}}};
+        setup();
+        set_page_nofill();
+        expect(eq(at(0x50000), initial));
+        expect(eq(at(0x50000 + (pages - 1) * page_size + page_size / 2), initial));
+        expect(eq(arena::metrics().fill.count, 0U));
+    };
+    "writes are private to the page"_test = [] {
+        set_page_fill(initial, page_fill_type::mapped);
+        const stub setup {{address(0x50000), modified}, {address(0x51000), initial}};
+        setup();
+        set_page_nofill();
+        expect(eq(at(0x50000), modified));
+        expect(eq(at(0x50008), initial));
+        expect(eq(at(0x51000), initial));
+        expect(eq(at(0x51008), initial));
+    };
+    "pages keep the value they were filled with"_test = [] {
+        set_page_fill(initial, page_fill_type::mapped);
+        const stub first {{{0x50000, page_size}}};
+        first();
+        set_page_fill(modified, page_fill_type::mapped);
+        const stub second {{{0x51000, page_size}}};
+        second();
+        set_page_nofill();
+        expect(eq(at(0x50000), initial));
+        expect(eq(at(0x51000), modified));
+    };
+    "reserved pages are zeroed after mapped fill"_test = [] {
+        reserved_arena reserved {};
+        {
+            set_page_fill(initial, page_fill_type::mapped);
+            const stub setup {{{0x50000, 2 * page_size}}};
+            setup();
+            set_page_nofill();
+            expect(eq(at(0x51000), initial));
+        }
+        const stub setup {{{0x50000, 2 * page_size}}};
+        setup();
+        expect(at(0x51000) == 0U);
+    };
+};
+
+suite<"arena metrics"> arena_metrics_suite = [] {
+    "mappings are counted by stub location"_test = [] {
+        arena::reset_metrics();
+        const auto mapped = arena::metrics().mapped_bytes;
+        {
+            const stub setup {{address(0x50000), initial}, {address(0x52000), initial}};
+            setup();
+            const auto metrics = arena::metrics();
+            expect(eq(metrics.map.count, 2U));
+            expect(metrics.map.time > std::chrono::nanoseconds {});
+            expect(eq(metrics.mapped_bytes - mapped, 2 * page_size));
+            expect(eq(metrics.peak_mapped_bytes, metrics.mapped_bytes));
+            expect(ge(metrics.allocations, 2U));
+            expect(eq(metrics.sites.size(), 1U));
+            if (metrics.sites.empty()) return;
+            expect(eq(metrics.sites.front().location.line(), setup.location().line()));
+            expect(eq(metrics.sites.front().map.count, 2U));
+        }
+        const auto metrics = arena::metrics();
+        expect(eq(metrics.unmap.count, 2U));
+        expect(eq(metrics.mapped_bytes, mapped));
+        expect(eq(metrics.peak_mapped_bytes - mapped, 2 * page_size));
+    };
+    "fills are counted"_test = [] {
+        arena::reset_metrics();
+        set_page_fill(initial);
+        const stub setup {{address(0x50000), modified}};
+        setup();
+        set_page_nofill();
+        expect(eq(arena::metrics().fill.count, 1U));
+    };
+    "page faults are sampled"_test = [] {
+        constexpr std::size_t pages = 16;
+        const stub setup {{{0x50000, pages * page_size}}};
+        setup();
+        arena::reset_metrics();
+        for(std::size_t i = 0; i < pages; ++i) at(0x50000 + i * page_size) = modified;
+        expect(ge(arena::metrics().minor_faults, pages));
+    };
+    "metrics are formatted as JSON and Prometheus text"_test = [] {
+        arena::reset_metrics();
+        const stub setup {{address(0x50000), initial}};
+        setup();
+        const auto metrics = arena::metrics();
+        expect(metrics.json().starts_with(R"({"map": {"count": 1, )"));
+        expect(metrics.json().contains(R"("sites": [{"file": ")"));
+        expect(metrics.prometheus().contains("\nstubmmio_arena_map_total 1\n"));
+        expect(metrics.prometheus().contains("stubmmio_arena_site_map_seconds_total{file=\""));
+    };
+};
+
+} // namespace
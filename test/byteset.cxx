@@ -0,0 +1,47 @@
+/*
+ * Copyright (C) 2025 Eugene Hutorny <eugene@hutorny.in.ua>
+ *
+ * test/byteset.cxx - unit tests for byte set
+ *
+ * Licensed under MIT License, see full text in LICENSE
+ * or visit page https://opensource.org/license/mit/
+ */
+
+#include <stubmmio/unit.h>
+#include <byteset.h>
+
+namespace {
+using namespace stubmmio::detail;
+using namespace boost::ut;
+using namespace boost::ut::bdd;
+
+suite<"byteset"> byteset_suite = [] {
+    "append coalesces adjacent and overlapping ranges"_test = [] {
+        const byteset sut {{0x10, 0x14}, {0x14, 0x18}, {0x16, 0x1A}, {0x20, 0x24}, {0x28, 0x28}};
+        expect(sut == byteset{{0x10, 0x1A}, {0x20, 0x24}});
+    };
+    "within clips ranges to the window"_test = [] {
+        const byteset sut {{0x10, 0x20}, {0x30, 0x40}, {0x50, 0x60}};
+        expect(sut.within({0x18, 0x38}) == byteset{{0x18, 0x20}, {0x30, 0x38}});
+        expect(sut.within({0x20, 0x30}).empty());
+        expect(sut.within({0x00, 0x70}) == sut);
+    };
+    "assign replaces ranges within the window"_test = [] {
+        byteset sut {{0x10, 0x20}, {0x30, 0x40}};
+        sut.assign({0x18, 0x38}, {{0x00, 0x04}, {0x1C, 0x24}, {0x34, 0x3C}});
+        expect(sut == byteset{{0x10, 0x18}, {0x1C, 0x24}, {0x34, 0x40}});
+    };
+    "merge adds ranges of the other set"_test = [] {
+        byteset sut {{0x10, 0x20}, {0x40, 0x50}};
+        sut.merge({{0x00, 0x08}, {0x20, 0x28}, {0x30, 0x48}});
+        expect(sut == byteset{{0x00, 0x08}, {0x10, 0x28}, {0x30, 0x50}});
+    };
+    "overlap returns first overlapping bytes"_test = [] {
+        const byteset sut {{0x10, 0x20}, {0x30, 0x40}};
+        expect(! sut.overlap({{0x00, 0x10}, {0x20, 0x30}, {0x40, 0x50}}).has_value());
+        const auto found = sut.overlap({{0x20, 0x34}});
+        expect(found.has_value() && *found == byterange{0x30, 0x34});
+    };
+};
+
+} // namespace
@@ -0,0 +1,51 @@
+/*
+ * Copyright (C) 2025 Eugene Hutorny <eugene@hutorny.in.ua>
+ *
+ * test/compare.cxx - unit tests for memory comparison kernels
+ *
+ * Licensed under MIT License, see full text in LICENSE
+ * or visit page https://opensource.org/license/mit/
+ */
+
+#include <stubmmio/unit.h>
+#include <compare.h>
+#include <array>
+#include <vector>
+
+using namespace stubmmio::detail;
+
+namespace {
+using namespace boost::ut;
+using namespace boost::ut::bdd;
+
+suite<"compare"> compare_suite = [] {
+    "mismatch finds first different byte at any offset"_test = [] {
+        std::vector<std::byte> image(257);
+        for(std::size_t i = 0; i < image.size(); ++i) image[i] = static_cast<std::byte>(i);
+        for(std::size_t size : {0UL, 1UL, 15UL, 16UL, 33UL, 64UL, 257UL}) {
+            auto data = image;
+            expect(eq(find_mismatch(data.data(), image.data(), size), size));
+            for(std::size_t at = 0; at < size; at += 7) {
+                data = image;
+                data[at] = ~data[at];
+                expect(eq(find_mismatch(data.data(), image.data(), size), at));
+            }
+        }
+    };
+    "mismatch finds first byte not matching pattern"_test = [] {
+        for(std::size_t pattern_size : {1UL, 2UL, 3UL, 4UL, 12UL, 16UL}) {
+            std::array<std::byte, 16> pattern {};
+            for(std::size_t i = 0; i < pattern_size; ++i) pattern[i] = static_cast<std::byte>(0xA0 + i);
+            std::vector<std::byte> data(pattern_size * 100);
+            for(std::size_t i = 0; i < data.size(); ++i) data[i] = pattern[i % pattern_size];
+            expect(eq(find_mismatch(data.data(), data.size(), pattern.data(), pattern_size), data.size()));
+            for(std::size_t at : {0UL, 1UL, 31UL, 99UL, data.size() - 1}) {
+                auto modified = data;
+                modified[at] = std::byte{};
+                expect(eq(find_mismatch(modified.data(), modified.size(), pattern.data(), pattern_size), at));
+            }
+        }
+    };
+};
+
+} // namespace
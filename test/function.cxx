@@ -0,0 +1,62 @@
+/*
+ * Copyright (C) 2025 Eugene Hutorny <eugene@hutorny.in.ua>
+ *
+ * test/function.cxx - unit tests for small_function
+ *
+ * Licensed under MIT License, see full text in LICENSE
+ * or visit page https://opensource.org/license/mit/
+ */
+
+#include <stubmmio/stubmmio.h>
+#include <stubmmio/unit.h>
+#include <array>
+#include <memory>
+
+using namespace stubmmio;
+using namespace stubmmio::detail;
+
+namespace {
+using namespace boost::ut;
+using namespace boost::ut::bdd;
+using function_type = small_function<int(int)>;
+
+suite<"small function"> small_function_suite = [] {
+    "small callable is kept inline"_test = [] {
+        const function_type sut { [offset = 5](int v) noexcept { return v + offset; } };
+        expect(sut.is_inline());
+        expect(eq(sut(1), 6));
+    };
+    "large callable is allocated"_test = [] {
+        std::array<int, 16> data { 1, 2, 3 };
+        const function_type sut { [data](int v) noexcept { return data[static_cast<std::size_t>(v)]; } };
+        expect(!sut.is_inline());
+        expect(eq(sut(2), 3));
+    };
+    "copies are independent"_test = [] {
+        function_type source { [count = 0](int v) mutable noexcept { return count += v; } };
+        expect(eq(source(1), 1));
+        const function_type sut { source };
+        expect(eq(sut(1), 2));
+        expect(eq(source(5), 6));
+    };
+    "move leaves source empty"_test = [] {
+        auto counter = std::make_shared<int>(0);
+        function_type source { [counter](int v) noexcept { return *counter += v; } };
+        function_type sut { std::move(source) };
+        expect(!static_cast<bool>(source));
+        expect(eq(sut(3), 3));
+        expect(eq(counter.use_count(), 2L));
+        sut = function_type {};
+        expect(eq(counter.use_count(), 1L));
+    };
+    "empty function throws"_test = [] {
+        const function_type sut {};
+        expect(throws<std::bad_function_call>([&sut] { sut(1); }));
+    };
+    "value and location fit inline"_test = [] {
+        expect(static_cast<bool>(generator::operator_type::fits<decltype(generator::one(std::array<std::uint32_t, 4>{}))>));
+        expect(static_cast<bool>(comparator::operator_type::fits<decltype(comparator::all(std::array<std::uint32_t, 4>{}))>));
+    };
+};
+
+} // namespace
@@ -9,16 +9,61 @@
 
 #include <stubmmio/stubmmio.h>
 #include <stubmmio/logger.h>
+#include <stubmmio/runner.h>
 #include <stubmmio/unit.h>
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <format>
 #include <iostream>
+#include <span>
+#include <string_view>
+#include <sys/wait.h>
+#include <unistd.h>
 
 using namespace stubmmio;
+namespace {
+
+/// runs the suite, filtered by name, in a process forked from the runner worker, as ut runs suites once per process
+bool run_suite(const char* name) {
+    const auto pid = fork();
+    if (pid < 0) return false;
+    if (pid == 0) {
+        const char* args[] { "stubmmio", name, nullptr };
+        const auto result = boost::ut::cfg<>.run(boost::ut::run_cfg{.argc = 2, .argv = args});
+        std::cout.flush();
+        std::fflush(nullptr);
+        _exit(result);
+    }
+    int wstatus = 0;
+    while(waitpid(pid, &wstatus, 0) < 0) {
+        if (errno != EINTR) return false;
+    }
+    return WIFEXITED(wstatus) && WEXITSTATUS(wstatus) == 0;
+}
+
+/// runs the suites in parallel, a test case of stubmmio::runner per suite
+int run_parallel(std::span<char*> suites) {
+    runner parallel {};
+    for(const auto suite : suites) parallel.add(suite, [suite] { return run_suite(suite); });
+    const auto result = parallel.run();
+    std::cout << std::format("suites: {} passed, {} failed, {} crashed\n", result.passed, result.failed, result.crashed);
+    std::cout.flush();
+    std::fflush(nullptr);
+    // suites are not run by ut in this process, quick_exit skips ut running them at exit
+    std::quick_exit(result.success() ? EXIT_SUCCESS : EXIT_FAILURE);
+}
+
+} // namespace
+
 int main(int argc, char *argv[]) {
     logcategory::basic::level(priority::warning); // warning level for all log categories
     util::redirect logging(logovod::sink::clog);  // using clog for logging for the scope of main
     arena::check_boundary();
     arena::check_pagesize(getpagesize());
     util::handle_sigsegv();
+    if (argc > 1 && std::string_view{argv[1]} == "--parallel")
+        return run_parallel(std::span{argv + 2, static_cast<std::size_t>(argc - 2)});
     auto result = boost::ut::cfg<>.run(boost::ut::run_cfg{.argc = argc, .argv = const_cast<const char**>(argv)});
     return result;
 }
@@ -0,0 +1,84 @@
+/*
+ * Copyright (C) 2025 Eugene Hutorny <eugene@hutorny.in.ua>
+ *
+ * test/pageindex.cxx - unit tests for page index
+ *
+ * Licensed under MIT License, see full text in LICENSE
+ * or visit page https://opensource.org/license/mit/
+ */
+
+#include <stubmmio/stubmmio.h>
+#include <stubmmio/unit.h>
+#include <pageindex.h>
+#include <iterator>
+
+namespace {
+using namespace stubmmio::detail;
+using namespace stubmmio::test;
+using namespace boost::ut;
+using namespace boost::ut::bdd;
+constexpr auto operator""_n(unsigned long long int v) {
+    return static_cast<pageid_type>(v / page_size);
+}
+
+struct entry {
+    pagerange range;
+    unsigned tag;
+};
+
+pageindex<entry> make_index() {
+    pageindex<entry> result {};
+    result.insert({{0x10000_p, 0x12000_p}, 1});
+    result.insert({{0x14000_p, 0x15000_p}, 2});
+    result.insert({{0x15000_p, 0x18000_p}, 3});
+    return result;
+}
+
+suite<"pageindex"> pageindex_suite = [] {
+    "find returns entry containing the page"_test = [] {
+        const auto sut = make_index();
+        expect(eq(sut.find(0x10000_n)->second.tag, 1U));
+        expect(eq(sut.find(0x11000_n)->second.tag, 1U));
+        expect(eq(sut.find(0x15000_n)->second.tag, 3U));
+        expect(eq(sut.find(0x17000_n)->second.tag, 3U));
+    };
+    "find returns end for pages outside of entries"_test = [] {
+        const auto sut = make_index();
+        expect(sut.find(0x0F000_n) == sut.end());
+        expect(sut.find(0x12000_n) == sut.end());
+        expect(sut.find(0x18000_n) == sut.end());
+    };
+    "intersecting returns entries partially covered by the range"_test = [] {
+        const auto sut = make_index();
+        const auto found = sut.intersecting({0x11000_p, 0x16000_p});
+        expect(eq(std::ranges::distance(found), 3));
+        expect(eq(found.begin()->second.tag, 1U));
+    };
+    "intersecting ignores adjacent entries"_test = [] {
+        const auto sut = make_index();
+        expect(sut.intersecting({0x12000_p, 0x14000_p}).empty());
+        expect(sut.intersecting({0x18000_p, 0x19000_p}).empty());
+        expect(eq(std::ranges::distance(sut.intersecting({0x13000_p, 0x15000_p})), 1));
+    };
+    "covers returns true for range within one entry"_test = [] {
+        const auto sut = make_index();
+        expect(sut.covers({0x10000_p, 0x12000_p}));
+        expect(sut.covers({0x16000_p, 0x16004_p}));
+    };
+    "covers returns true for range spanning adjacent entries"_test = [] {
+        const auto sut = make_index();
+        expect(sut.covers({0x14000_p, 0x18000_p}));
+    };
+    "covers returns false for range with a gap"_test = [] {
+        const auto sut = make_index();
+        expect(!sut.covers({0x11000_p, 0x15000_p}));
+        expect(!sut.covers({0x17000_p, 0x19000_p}));
+    };
+    "erase removes intersecting entries"_test = [] {
+        auto sut = make_index();
+        sut.erase(sut.intersecting({0x14000_p, 0x16000_p}));
+        expect(eq(sut.size(), 1U));
+        expect(!sut.covers({0x14000_p, 0x15000_p}));
+    };
+};
+} // namespace
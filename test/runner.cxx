@@ -0,0 +1,108 @@
+/*
+ * Copyright (C) 2025 Eugene Hutorny <eugene@hutorny.in.ua>
+ *
+ * test/runner.cxx - unit tests for parallel test runner
+ *
+ * Licensed under MIT License, see full text in LICENSE
+ * or visit page https://opensource.org/license/mit/
+ */
+
+#include <stubmmio/stubmmio.h>
+#include <stubmmio/stimulus.h>
+#include <stubmmio/runner.h>
+#include <stubmmio/logger.h>
+#include <stubmmio/unit.h>
+#include <chrono>
+#include <cstdlib>
+#include <stdexcept>
+#include <thread>
+#include <sys/wait.h>
+#include <unistd.h>
+
+using namespace stubmmio;
+
+namespace {
+using namespace std::chrono_literals;
+using namespace boost::ut;
+using namespace boost::ut::bdd;
+using namespace boost::ut::literals;
+using status_type = stubmmio::runner::status_type;
+
+constexpr test::native_type initial = 0xA5A5A5A5U;
+
+template<typename T = test::native_type>
+auto& at(std::uintptr_t addr) {
+    return *reinterpret_cast<volatile T*>(addr);
+}
+
+suite<"runner"> runner_suite = [] {
+    "runner aggregates results"_test = [] {
+        util::scoped_redirector<logcategory::runner> ignore {};
+        const auto result = stubmmio::runner { 2 }
+            .add("passes", []() noexcept { return true; })
+            .add("fails", []() noexcept { return false; })
+            .add("throws", []() -> bool { throw std::logic_error("test"); })
+            .add("crashes", []() noexcept -> bool { std::abort(); })
+            .add("passes after crash", []() noexcept { return true; })
+            .run();
+        expect(eq(result.passed, 2U));
+        expect(eq(result.failed, 2U));
+        expect(eq(result.crashed, 1U));
+        expect(!result.success());
+        expect(result.statuses.at(3) == status_type::crashed);
+        expect(result.statuses.at(4) == status_type::passed);
+    };
+    "all cases run when every worker crashes"_test = [] {
+        util::scoped_redirector<logcategory::runner> ignore {};
+        stubmmio::runner sut { 2 };
+        for(unsigned i = 0; i < 5; ++i) sut.add("crashes", []() noexcept -> bool { std::abort(); });
+        const auto result = sut.run();
+        expect(eq(result.crashed, 5U));
+    };
+    "workers share stubs applied before the run"_test = [] {
+        stub setup {{address(0x60000), initial}};
+        setup();
+        stubmmio::runner sut { 2 };
+        for(test::native_type i = 0; i < 4; ++i) {
+            sut.add("modifies", [i] {
+                at(0x60000) = i;
+                return verify {{address(0x60000), i}}();
+            });
+        }
+        const auto result = sut.run();
+        expect(eq(result.passed, 4U));
+        expect(at(0x60000) == initial);
+    };
+    "stimuli run in workers"_test = [] {
+        stub setup {{address(0x60000), 0U}, {address(0x60004), 0U}};
+        setup();
+        expect(eq(istimulus::count(), 0U));
+        const auto result = stubmmio::runner { 2 }.add("stimulus", [] {
+            stimulus sut {
+                address(0x60000), [](volatile const std::uint32_t& var) { return var != 0; },
+                address(0x60004), [](volatile std::uint32_t& var) {  var = 1U; }
+            };
+            at(0x60000) = 1U;
+            const auto finish_by = std::chrono::steady_clock::now() + 100ms;
+            while(sut.status() != istimulus::status_type::done && std::chrono::steady_clock::now() < finish_by)
+                std::this_thread::yield();
+            return at(0x60004) == 1U;
+        }).run();
+        expect(result.success());
+    };
+    "other children of the process are not reaped"_test = [] {
+        const auto other = fork();
+        if (other == 0) _exit(7);
+        expect(other > 0);
+        if (other < 0) return;
+        siginfo_t info {};
+        expect(eq(waitid(P_PID, static_cast<id_t>(other), &info, WEXITED | WNOWAIT), 0)); // exited, yet not reaped
+        const auto result = stubmmio::runner { 2 }.add("passes", []() noexcept { return true; }).run();
+        expect(result.success());
+        int wstatus = 0;
+        expect(eq(waitpid(other, &wstatus, 0), other));
+        expect(WIFEXITED(wstatus) && WEXITSTATUS(wstatus) == 7);
+    };
+};
+
+} // namespace
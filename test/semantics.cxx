@@ -0,0 +1,146 @@
+/*
+ * Copyright (C) 2025 Eugene Hutorny <eugene@hutorny.in.ua>
+ *
+ * test/semantics.cxx - unit tests for register access semantics
+ *
+ * Licensed under MIT License, see full text in LICENSE
+ * or visit page https://opensource.org/license/mit/
+ */
+
+#include <stubmmio/stubmmio.h>
+#include <stubmmio/literals.h>
+#include <stubmmio/semantics.h>
+#include <stubmmio/snapshot.h>
+#include <stubmmio/stimulus.h>
+#include <stubmmio/unit.h>
+#include <cstdint>
+
+namespace {
+using namespace boost::ut;
+using namespace boost::ut::bdd;
+using namespace stubmmio;
+using namespace stubmmio::literals;
+
+constexpr std::uintptr_t base = 0x69000;
+
+template<typename T = std::uint32_t>
+auto at(std::uintptr_t addr) {
+    return reinterpret_cast<volatile T*>(addr);
+}
+
+suite<"semantics"> semantics_suite = [] {
+    "write 1 clears bits"_test = [] {
+        stub setup {{address(base), 0x00FF_U32}};
+        setup();
+        semantics rules {{ at(base), { .write_1_to_clear = 0x00FF } }};
+        if (! rules.active()) return;
+        *at(base) = 0x0003U;
+        expect(eq(*at(base), 0x00FCU));
+        *at(base) = 0x0000U;
+        expect(eq(*at(base), 0x00FCU));
+        *at(base) = 0x1F00U;
+        expect(eq(*at(base), 0x1FFCU));
+    };
+    "read only bits ignore writes"_test = [] {
+        stub setup {{address(base), 0xA500_U32}};
+        setup();
+        semantics rules {{ at(base), { .read_only = 0xFF00 } }};
+        if (! rules.active()) return;
+        *at(base) = 0x0042U;
+        expect(eq(*at(base), 0xA542U));
+        *at(base) = 0xFFFFU;
+        expect(eq(*at(base), 0xA5FFU));
+    };
+    "read clears bits"_test = [] {
+        stub setup {{address(base), 0x8001_U32}, {address(base + 4), 0x8001_U32}};
+        setup();
+        semantics rules {{ at(base), { .read_to_clear = 0x8000 } }};
+        if (! rules.active()) return;
+        expect(eq(*at(base), 0x8001U));
+        expect(eq(*at(base), 0x0001U));
+        expect(eq(*at(base + 4), 0x8001U));
+        expect(eq(*at(base + 4), 0x8001U));
+    };
+    "alias sets, clears and toggles target bits"_test = [] {
+        stub setup {{address(base), 0x0F_U32}, {address(base + 4), 0_U32}, {address(base + 8), 0_U32},
+                    {address(base + 12), 0_U32}};
+        setup();
+        semantics rules {
+            { at(base + 4), semantics::alias_type::set, at(base) },
+            { at(base + 8), semantics::alias_type::clear, at(base) },
+            { address(base + 12), semantics::alias_type::toggle, address(base) },
+        };
+        if (! rules.active()) return;
+        *at(base + 4) = 0x30U;
+        expect(eq(*at(base), 0x3FU));
+        expect(eq(*at(base + 4), 0U));
+        *at(base + 8) = 0x03U;
+        expect(eq(*at(base), 0x3CU));
+        *at(base + 12) = 0x0FU;
+        expect(eq(*at(base), 0x33U));
+    };
+    "other registers of the page are plain"_test = [] {
+        stub setup {{address(base), 0xFF_U32}, {address(base + 4), 0xFF_U32}};
+        setup();
+        semantics rules {{ at(base), { .write_1_to_clear = 0xFF, .read_to_clear = 0x100 } }};
+        if (! rules.active()) return;
+        *at(base + 4) = 0x01U;
+        expect(eq(*at(base + 4), 0x01U));
+        *at<std::uint8_t>(base + 5) = 0x02U;
+        expect(eq(*at(base + 4), 0x0201U));
+    };
+    "semantics are detached on destruction"_test = [] {
+        stub setup {{address(base), 0xFF_U32}};
+        setup();
+        {
+            semantics rules {{ at(base), { .write_1_to_clear = 0xFF } }};
+            if (! rules.active()) return;
+        }
+        *at(base) = 0x01U;
+        expect(eq(*at(base), 0x01U));
+    };
+    "register must be stubbed and governed once"_test = [] {
+        expect(throws<exceptions::page_is_not_allocated>([] {
+            semantics rules {{ at(base + 0x10000), { .read_only = 1 } }};
+        }));
+        stub setup {{address(base), 0_U32}};
+        setup();
+        semantics rules {{ at(base), { .read_only = 1 } }};
+        if (! rules.active()) return;
+        expect(throws<exceptions::duplicate_address>([] {
+            semantics other {{ at<std::uint8_t>(base + 1), { .read_only = 1 } }};
+        }));
+        *at(base) = 0x03U;
+        expect(eq(*at(base), 0x02U));
+    };
+    "semantics are enforced after snapshot"_test = [] {
+        stub setup {{address(base), 0x00FF_U32}};
+        setup();
+        semantics rules {{ at(base), { .write_1_to_clear = 0x00FF } }};
+        if (! rules.active()) return;
+        *at(base) = 0x0001U;
+        expect(eq(*at(base), 0x00FEU));
+        const snapshot image {};
+        *at(base) = 0x0002U;
+        expect(eq(*at(base), 0x00FCU));
+        image.restore();
+        *at(base) = 0x0004U;
+        expect(eq(*at(base), 0x00FAU));
+    };
+    "write to register with semantics runs trapped stimulus"_test = [] {
+        stub setup {{address(base), 0x01_U32}, {address(base + 4), 0_U32}};
+        setup();
+        semantics rules {{ at(base), { .write_1_to_clear = 0x01 } }};
+        if (! rules.active() || ! istimulus::mode(istimulus::mode_type::trap)) return;
+        stimulus sut {
+            address(base), [](volatile const std::uint32_t& status) { return status == 0; },
+            address(base + 4), [](volatile std::uint32_t& flag) { flag = 1U; }
+        };
+        *at(base) = 0x01U;
+        istimulus::mode(istimulus::mode_type::poll);
+        expect(sut.status() == istimulus::status_type::done);
+        expect(eq(*at(base + 4), 1U));
+    };
+};
+
+} // namespace
@@ -0,0 +1,75 @@
+/*
+ * Copyright (C) 2025 Eugene Hutorny <eugene@hutorny.in.ua>
+ *
+ * test/snapshot.cxx - unit tests for snapshot
+ *
+ * Licensed under MIT License, see full text in LICENSE
+ * or visit page https://opensource.org/license/mit/
+ */
+
+#include <stubmmio/stubmmio.h>
+#include <stubmmio/snapshot.h>
+#include <stubmmio/unit.h>
+#include <mmio.h>
+
+using namespace stubmmio;
+using namespace stubmmio::detail;
+
+namespace {
+using namespace boost::ut;
+using namespace boost::ut::bdd;
+using namespace boost::ut::literals;
+
+constexpr test::native_type initial = 0xA5A5A5A5U;
+constexpr test::native_type modified = 0x5A5A5A5AU;
+
+template<typename T = test::native_type>
+auto& at(std::uintptr_t addr) {
+    return *reinterpret_cast<volatile T*>(addr);
+}
+
+suite<"snapshot"> snapshot_suite = [] {
+    "snapshot captures allocated pages"_test = [] {
+        stub setup {{address(0x30000), initial}, {address(0x32000), initial}};
+        setup();
+        const snapshot sut {};
+        expect(eq(sut.size_bytes(), 2 * page_size));
+        expect(at(0x30000) == initial);
+        expect(at(0x32000) == initial);
+    };
+    "restore discards modifications"_test = [] {
+        stub setup {{address(0x30000), initial}, {address(0x32000), initial}};
+        setup();
+        const snapshot sut {};
+        at(0x30000) = modified;
+        at(0x32004) = modified;
+        sut.restore();
+        expect(verify {{address(0x30000), initial}, {address(0x32000), initial}, {address(0x32004), 0U}}());
+    };
+    "restore can be repeated"_test = [] {
+        stub setup {{address(0x30000), initial}};
+        setup();
+        const snapshot sut {};
+        for(unsigned i = 0; i < 3; ++i) {
+            at(0x30000) = modified + i;
+            sut();
+            expect(at(0x30000) == initial);
+        }
+    };
+    "restore throws when pages are deallocated"_test = [] {
+        std::optional<stub> setup {{{address(0x30000), initial}}};
+        (*setup)();
+        const snapshot sut {};
+        setup.reset();
+        expect(throws([&sut] { sut.restore(); }));
+    };
+    "restore throws when pages are reallocated"_test = [] {
+        stub setup {{address(0x30000), initial}};
+        setup();
+        const snapshot sut {};
+        setup();
+        expect(throws([&sut] { sut.restore(); }));
+    };
+};
+
+} // namespace
@@ -0,0 +1,78 @@
+/*
+ * Copyright (C) 2025 Eugene Hutorny <eugene@hutorny.in.ua>
+ *
+ * test/static_stub.cxx - unit tests for static stub
+ *
+ * Licensed under MIT License, see full text in LICENSE
+ * or visit page https://opensource.org/license/mit/
+ */
+
+#include <stubmmio/stubmmio.h>
+#include <stubmmio/unit.h>
+#include <mmio.h>
+
+using namespace stubmmio;
+using namespace stubmmio::detail;
+
+namespace {
+using namespace boost::ut;
+using namespace boost::ut::bdd;
+using namespace boost::ut::literals;
+
+template<typename T = test::native_type>
+auto& at(std::uintptr_t addr) {
+    return *reinterpret_cast<volatile T*>(addr);
+}
+
+constexpr static_stub reset_state {
+    static_element{address(0x74004), 0x5A697887U},
+    static_fill{region{0x75000, 16}, std::uint16_t{0xA5A5}},
+    static_element{address(0x74000), 0x1E2D3C4BU},
+    static_region{region{0x75FFC, 8}},
+    static_element{address(0x78000), std::array<std::uint8_t, 4>{1, 2, 3, 4}},
+};
+
+static_assert(reset_state.element_count() == 5);
+static_assert(reset_state.page_range_count() == 2);
+static_assert(reset_state.table().records.front().address == 0x74000);
+static_assert(reset_state.table().pages.front().address == 0x74000);
+static_assert(reset_state.table().pages.front().size == 3 * page_size);
+static_assert(reset_state.table().data.size() == 14);
+
+suite<"static stub"> static_stub_suite = [] {
+    "static stub initializes elements"_test = [] {
+        const auto mappings = mmio::arena().mapping_count();
+        stub sut { reset_state };
+        sut();
+        expect(eq(sut.element_count(), 5U));
+        expect(eq(mmio::arena().mapping_count() - mappings, 2U));
+        expect(verify {
+            {address(0x74000), 0x1E2D3C4BU},
+            {address(0x74004), 0x5A697887U},
+            {std::span{reinterpret_cast<std::uint16_t*>(0x75000), 8}, std::uint16_t{0xA5A5}},
+            {address(0x78000), std::array<std::uint8_t, 4>{1, 2, 3, 4}},
+        }());
+    };
+    "static stub combines with dynamic stub"_test = [] {
+        stub sut { reset_state };
+        sut |= stub {{address(0x79000), 7U}};
+        sut();
+        expect(eq(sut.element_count(), 6U));
+        expect(at(0x74000) == 0x1E2D3C4BU);
+        expect(at(0x79000) == 7U);
+    };
+    "static stub overlapping dynamic one throws"_test = [] {
+        stub sut {{address(0x74004), 7U}};
+        expect(throws<exceptions::duplicate_address>([&sut] { sut |= stub { reset_state }; }));
+    };
+    "moved static stub owns pages"_test = [] {
+        stub source { reset_state };
+        source();
+        stub sut { std::move(source) };
+        sut();
+        expect(eq(sut.element_count(), 5U));
+        expect(at(0x74004) == 0x5A697887U);
+    };
+};
+
+} // namespace
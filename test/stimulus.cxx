@@ -8,15 +8,23 @@
  */
 #include <stubmmio/stimulus.h>
 #include <stubmmio/stubmmio.h>
+#include <stubmmio/snapshot.h>
 #include <stubmmio/literals.h>
 #include <stubmmio/unit.h>
 #include <stubmmio/logger.h>
 
+#include <atomic>
 #include <thread>
+#include <list>
 #include <mutex>
 #include <condition_variable>
 #include <vector>
 #include <chrono>
+#include <ctime>
+#include <numeric>
+#include <optional>
+#include <fcntl.h>
+#include <unistd.h>
 #pragma GCC diagnostic ignored "-Warray-bounds"
 
 namespace {
@@ -81,6 +89,17 @@ constexpr stimulus constexpr_stimulus  { inactive,
     address(4004), &test_action,
 };
 
+bool wait_status(const istimulus& sut, istimulus::status_type status) {
+    const auto finish_by = std::chrono::steady_clock::now() + 100ms;
+    while(sut.status() != status && std::chrono::steady_clock::now() < finish_by)
+        std::this_thread::yield();
+    return sut.status() == status;
+}
+
+bool wait_done(const istimulus& sut) {
+    return wait_status(sut, istimulus::status_type::done);
+}
+
 suite<"stimulus"> stimulus_suite = [] {
     "primary constructor"_test = [] {
         volatile bool watch_bool {};
@@ -232,6 +251,490 @@ suite<"stimulus"> stimulus_suite = [] {
         expect(*test_addr<uint32_t>(2004) == 1U);
         expect(eq(istimulus::count(), 0U));
     };
+    "idle stimulator sleeps"_test = [] {
+        expect(eq(istimulus::count(), 0U));
+        timespec before {}, after {};
+        clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &before);
+        std::this_thread::sleep_for(50ms);
+        clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &after);
+        const auto used = (after.tv_sec - before.tv_sec) * 1000000000L + after.tv_nsec - before.tv_nsec;
+        expect(lt(used, 10'000'000L));
+    };
+    "stimulus completes with backoff"_test = [] {
+        const auto saved = istimulus::backoff();
+        istimulus::backoff({ 0, 0, 2ms });
+        expect(istimulus::backoff().sleep == 2ms);
+        stub setup { test_mmio<0x5000> };
+        setup();
+        stimulus sut { active_stimulus<0x5000>() };
+        std::this_thread::sleep_for(10ms);
+        *test_addr<uint32_t>(0x5000) = 1U;
+        expect(wait_done(sut));
+        expect(*test_addr<uint32_t>(0x5004) == 2);
+        istimulus::backoff(saved);
+    };
+    "latency after idle backoff is bounded by sleep limit"_test = [] {
+        constexpr std::uint32_t base = 0xA000;
+        constexpr unsigned size = 256;
+        const auto saved = istimulus::backoff();
+        istimulus::backoff({ 16, 64, 500us });
+        stub setup { test_mmio<0x5000> };
+        setup();
+        stub registers {{address(base), std::array<uint32_t, size * 2>{}}};
+        registers();
+        std::list<std::remove_cv_t<decltype(constexpr_stimulus)>> background {};
+        for(unsigned i = 0; i < size; ++i) {
+            const auto addr = base + i * 2 * sizeof(uint32_t);
+            background.push_back({ inactive, address(addr), &test_condition, address(addr + sizeof(uint32_t)), &test_action });
+            background.back()();
+        }
+        stimulus sut { active_stimulus<0x5000>() };
+        // lets the worker reach the sleep phase
+        std::this_thread::sleep_for(300ms);
+        const auto start = std::chrono::steady_clock::now();
+        *test_addr<uint32_t>(0x5000) = 1U;
+        expect(wait_done(sut));
+        expect(std::chrono::steady_clock::now() - start < 20ms);
+        istimulus::backoff(saved);
+    };
+    "stimuli polled by pool of workers"_test = [] {
+        expect(istimulus::pool({ 4, { 0 } }));
+        expect(eq(istimulus::pool().workers, 4U));
+        {
+            stub setup { test_mmio<0x5000>, test_mmio<0x6000>, test_mmio<0x7000> };
+            setup();
+            stimulus first { active_stimulus<0x5000>() };
+            stimulus second { active_stimulus<0x6000>() };
+            stimulus grouped { inactive_stimulus<0x7000>() };
+            grouped.group(1);
+            grouped();
+            expect(eq(grouped.group(), 1U));
+            expect(eq(istimulus::count(), 3U));
+            expect(! istimulus::pool({ 2, {} }));
+            for(auto addr : { 0x5000U, 0x6000U, 0x7000U })
+                *test_addr<uint32_t>(addr) = 1U;
+            expect(wait_done(first));
+            expect(wait_done(second));
+            expect(wait_done(grouped));
+            expect(*test_addr<uint32_t>(0x7004) == 2);
+        }
+        expect(istimulus::pool({ 1, {} }));
+    };
+    "stimuli of two workers activating each other's ones do not deadlock"_test = [] {
+        expect(istimulus::pool({ 2, {} }));
+        {
+            static std::atomic<unsigned> arrived {};
+            static std::atomic<unsigned> activated {};
+            static std::atomic<unsigned> refused {};
+            static istimulus* targets[2] {};
+            arrived = activated = refused = 0;
+            // both actions submit at once, each to the worker of the other
+            static constexpr auto submit = [](istimulus& target) {
+                ++arrived;
+                const auto finish_by = std::chrono::steady_clock::now() + 100ms;
+                while(arrived < 2 && std::chrono::steady_clock::now() < finish_by) std::this_thread::yield();
+                try {
+                    target();
+                    ++activated;
+                } catch(const exceptions::stimulus_deadlock&) {
+                    ++refused;
+                }
+            };
+            stub setup { test_mmio<0x5000>, test_mmio<0x6000>, test_mmio<0x7000> };
+            setup();
+            stimulus left_target { inactive_stimulus<0x7000>() };
+            stimulus right_target { inactive_stimulus<0x7000>() };
+            left_target.group(1);
+            right_target.group(0);
+            targets[0] = &left_target;
+            targets[1] = &right_target;
+            stimulus left { inactive,
+                address(0x5000), [](volatile const uint32_t& var) { return var != 0; },
+                address(0x5004), [](volatile uint32_t&) { submit(*targets[0]); } };
+            stimulus right { inactive,
+                address(0x6000), [](volatile const uint32_t& var) { return var != 0; },
+                address(0x6004), [](volatile uint32_t&) { submit(*targets[1]); } };
+            left.group(0);
+            right.group(1);
+            left();
+            right();
+            *test_addr<uint32_t>(0x5000) = 1U;
+            *test_addr<uint32_t>(0x6000) = 1U;
+            expect(wait_done(left));
+            expect(wait_done(right));
+            expect(eq(activated + refused, 2U));
+            expect(refused >= 1U);
+        }
+        expect(istimulus::pool({ 1, {} }));
+    };
+    "regrouping keeps stimulus active"_test = [] {
+        expect(istimulus::pool({ 3, {} }));
+        {
+            stub setup { test_mmio<0x5000> };
+            setup();
+            stimulus sut { active_stimulus<0x5000>() };
+            sut.group(2);
+            expect(eq(istimulus::count(), 1U));
+            test_workflow(sut, *test_addr<uint32_t>(0x5000), 1U);
+            expect(*test_addr<uint32_t>(0x5004) == 2);
+        }
+        expect(istimulus::pool({ 1, {} }));
+    };
+    "stimuli removed out of order"_test = [] {
+        constexpr std::uint32_t base = 0x8000;
+        constexpr unsigned size = 16;
+        stub setup {{address(base), std::array<uint32_t, size * 2>{}}};
+        setup();
+        std::list<std::remove_cv_t<decltype(constexpr_stimulus)>> stimuli {};
+        for(unsigned i = 0; i < size; ++i) {
+            const auto addr = base + i * 2 * sizeof(uint32_t);
+            stimuli.push_back({ inactive, address(addr), &test_condition, address(addr + sizeof(uint32_t)), &test_action });
+            stimuli.back()();
+        }
+        expect(eq(istimulus::count(), size));
+        unsigned i = 0;
+        std::erase_if(stimuli, [&i](auto&) noexcept { return i++ % 3 == 0; });
+        expect(eq(istimulus::count(), stimuli.size()));
+        for(i = 0; i < size; ++i)
+            *test_addr<uint32_t>(base + i * 2 * sizeof(uint32_t)) = 1U;
+        for(auto& sut : stimuli)
+            expect(wait_done(sut));
+        expect(eq(istimulus::count(), 0U));
+        for(i = 0; i < size; ++i)
+            expect(eq(*test_addr<uint32_t>(base + (i * 2 + 1) * sizeof(uint32_t)), i % 3 == 0 ? 0U : 2U));
+    };
+};
+
+/// switches stimuli to the given mode for the scope of a test
+struct scoped_mode {
+    explicit scoped_mode(istimulus::mode_type mode) : supported { istimulus::mode(mode) } {}
+    ~scoped_mode() { istimulus::mode(istimulus::mode_type::poll); }
+    scoped_mode(const scoped_mode&) = delete;
+    scoped_mode(scoped_mode&&) = delete;
+    scoped_mode& operator=(const scoped_mode&) = delete;
+    scoped_mode& operator=(scoped_mode&&) = delete;
+    const bool supported;
+};
+
+suite<"stimulus trap"> stimulus_trap_suite = [] {
+    "write runs stimulus synchronously"_test = [] {
+        scoped_mode trap { istimulus::mode_type::trap };
+        if (! trap.supported) return;
+        stub setup { test_mmio<0x6000> };
+        setup();
+        stimulus sut { active_stimulus<0x6000>() };
+        expect(eq(istimulus::count(), 1U));
+        *test_addr<uint32_t>(0x6000) = 4U;
+        expect(sut.status() != istimulus::status_type::done);
+        expect(*test_addr<uint32_t>(0x6000) == 4U);
+        *test_addr<uint32_t>(0x6000) = 1U;
+        expect(sut.status() == istimulus::status_type::done);
+        expect(*test_addr<uint32_t>(0x6004) == 2U);
+        expect(eq(istimulus::count(), 0U));
+    };
+    "satisfied condition runs on activation"_test = [] {
+        scoped_mode trap { istimulus::mode_type::trap };
+        if (! trap.supported) return;
+        stub setup {{address(0x6000), 1_U32}, {address(0x6004), 0_U32}};
+        setup();
+        stimulus sut { active_stimulus<0x6000>() };
+        expect(sut.status() == istimulus::status_type::done);
+        expect(*test_addr<uint32_t>(0x6004) == 2U);
+    };
+    "action triggers another trapped stimulus"_test = [] {
+        scoped_mode trap { istimulus::mode_type::trap };
+        if (! trap.supported) return;
+        stub setup { test_mmio<0x6000>, test_mmio<0x7000> };
+        setup();
+        stimulus first {
+            address(0x6000), [](volatile const uint32_t& var) { return var != 0; },
+            address(0x7000), [](volatile uint32_t& var) {  var = 1U; }
+        };
+        stimulus second { active_stimulus<0x7000>() };
+        *test_addr<uint32_t>(0x6000) = 1U;
+        expect(first.status() == istimulus::status_type::done);
+        expect(second.status() == istimulus::status_type::done);
+        expect(*test_addr<uint32_t>(0x7004) == 2U);
+    };
+    "deactivated stimulus leaves page writable"_test = [] {
+        scoped_mode trap { istimulus::mode_type::trap };
+        if (! trap.supported) return;
+        stub setup { test_mmio<0x6000> };
+        setup();
+        {
+            stimulus sut { active_stimulus<0x6000>() };
+            expect(eq(istimulus::count(), 1U));
+        }
+        expect(eq(istimulus::count(), 0U));
+        *test_addr<uint32_t>(0x6000) = 1U;
+        expect(*test_addr<uint32_t>(0x6004) == 0U);
+    };
+    "write after snapshot runs stimulus"_test = [] {
+        scoped_mode trap { istimulus::mode_type::trap };
+        if (! trap.supported) return;
+        stub setup { test_mmio<0x6000> };
+        setup();
+        stimulus sut { active_stimulus<0x6000>() };
+        const snapshot image {};
+        *test_addr<uint32_t>(0x6000) = 1U;
+        expect(sut.status() == istimulus::status_type::done);
+        expect(*test_addr<uint32_t>(0x6004) == 2U);
+    };
+    "stimulus outside arena is polled"_test = [] {
+        scoped_mode trap { istimulus::mode_type::trap };
+        volatile bool watch_bool {};
+        volatile bool modify_bool {};
+        stimulus sut {
+            &watch_bool, [](volatile const bool& var) { return var; },
+            &modify_bool, [](volatile bool& var) {  var = true; }
+        };
+        test_workflow(sut, watch_bool, true);
+        expect(modify_bool);
+    };
+};
+
+/// returns true if the page is write protected with userfaultfd, as reported by pagemap
+bool write_protected(std::uintptr_t page) {
+    static constexpr std::uint64_t uffd_wp = 1ULL << 57;
+    const int fd = open("/proc/self/pagemap", O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return false;
+    std::uint64_t entry {};
+    const auto size = pread(fd, &entry, sizeof(entry), static_cast<off_t>(page / 4096 * sizeof(entry)));
+    close(fd);
+    return size == sizeof(entry) && (entry & uffd_wp) != 0;
+}
+
+suite<"stimulus userfault"> stimulus_userfault_suite = [] {
+    "write runs stimulus on watcher thread"_test = [] {
+        scoped_mode userfault { istimulus::mode_type::userfault };
+        if (! userfault.supported) return;
+        stub setup { test_mmio<0x6000> };
+        setup();
+        stimulus sut { active_stimulus<0x6000>() };
+        expect(eq(istimulus::count(), 1U));
+        *test_addr<uint32_t>(0x6000) = 4U;
+        expect(! wait_done(sut));
+        expect(*test_addr<uint32_t>(0x6000) == 4U);
+        *test_addr<uint32_t>(0x6000) = 1U;
+        expect(wait_done(sut));
+        expect(*test_addr<uint32_t>(0x6004) == 2U);
+        expect(eq(istimulus::count(), 0U));
+    };
+    "satisfied condition runs on activation"_test = [] {
+        scoped_mode userfault { istimulus::mode_type::userfault };
+        if (! userfault.supported) return;
+        stub setup {{address(0x6000), 1_U32}, {address(0x6004), 0_U32}};
+        setup();
+        stimulus sut { active_stimulus<0x6000>() };
+        expect(sut.status() == istimulus::status_type::done);
+        expect(*test_addr<uint32_t>(0x6004) == 2U);
+    };
+    "action triggers another watched stimulus"_test = [] {
+        scoped_mode userfault { istimulus::mode_type::userfault };
+        if (! userfault.supported) return;
+        stub setup { test_mmio<0x6000>, test_mmio<0x7000> };
+        setup();
+        stimulus first {
+            address(0x6000), [](volatile const uint32_t& var) { return var != 0; },
+            address(0x7000), [](volatile uint32_t& var) {  var = 1U; }
+        };
+        stimulus second { active_stimulus<0x7000>() };
+        *test_addr<uint32_t>(0x6000) = 1U;
+        expect(wait_done(first));
+        expect(wait_done(second));
+        expect(*test_addr<uint32_t>(0x7004) == 2U);
+    };
+    "deactivated stimulus leaves page writable"_test = [] {
+        scoped_mode userfault { istimulus::mode_type::userfault };
+        if (! userfault.supported) return;
+        stub setup { test_mmio<0x6000> };
+        setup();
+        {
+            stimulus sut { active_stimulus<0x6000>() };
+            expect(eq(istimulus::count(), 1U));
+        }
+        expect(eq(istimulus::count(), 0U));
+        *test_addr<uint32_t>(0x6000) = 1U;
+        expect(*test_addr<uint32_t>(0x6004) == 0U);
+    };
+    "stimulus removed with one of its pages unwatches the others"_test = [] {
+        util::scoped_redirector<logcategory::stimulus> ignore {};
+        scoped_mode userfault { istimulus::mode_type::userfault };
+        if (! userfault.supported) return;
+        stub kept {{address(0x7000), 0_U32}, {address(0x7004), 0_U32}};
+        kept();
+        std::optional<stimulus<uint64_t, uint32_t, simple_condition<uint64_t>, simple_action<uint32_t>>> sut {};
+        {
+            stub removed {{address(0x6FF8), 0_U32}, {address(0x6FFC), 0_U32}};
+            removed();
+            // the watched register spans both pages
+            sut.emplace(address(0x6FFC), [](volatile const uint64_t& var) noexcept { return var != 0; },
+                        address(0x7004), [](volatile uint32_t& var) noexcept { var = 1U; });
+            if (! write_protected(0x7000)) return;
+        }
+        expect(! write_protected(0x7000));
+        *test_addr<uint32_t>(0x7000) = 1U;
+        expect(eq(*test_addr<uint32_t>(0x7000), 1U));
+    };
+    "write after snapshot runs stimulus"_test = [] {
+        scoped_mode userfault { istimulus::mode_type::userfault };
+        if (! userfault.supported) return;
+        stub setup { test_mmio<0x6000> };
+        setup();
+        stimulus sut { active_stimulus<0x6000>() };
+        const snapshot image {};
+        *test_addr<uint32_t>(0x6000) = 1U;
+        expect(wait_done(sut));
+        expect(*test_addr<uint32_t>(0x6004) == 2U);
+    };
+};
+
+struct simulated_clock {
+    simulated_clock() : active { istimulus::clock(istimulus::clock_type::simulated) } {}
+    ~simulated_clock() { istimulus::clock(istimulus::clock_type::steady); }
+    simulated_clock(const simulated_clock&) = delete;
+    simulated_clock(simulated_clock&&) = delete;
+    simulated_clock& operator=(const simulated_clock&) = delete;
+    simulated_clock& operator=(simulated_clock&&) = delete;
+    const bool active;
+};
+
+suite<"stimulus delay"> stimulus_delay_suite = [] {
+    "action runs after delay"_test = [] {
+        stub setup { test_mmio<0x5000> };
+        setup();
+        stimulus sut { inactive_stimulus<0x5000>() };
+        sut.delay(20ms)();
+        const auto start = std::chrono::steady_clock::now();
+        *test_addr<uint32_t>(0x5000) = 1U;
+        expect(wait_status(sut, istimulus::status_type::scheduled));
+        expect(*test_addr<uint32_t>(0x5004) == 0U);
+        expect(eq(istimulus::count(), 1U));
+        while(sut.status() != istimulus::status_type::done && std::chrono::steady_clock::now() < start + 200ms)
+            std::this_thread::yield();
+        expect(sut.status() == istimulus::status_type::done);
+        expect(std::chrono::steady_clock::now() - start >= 20ms);
+        expect(*test_addr<uint32_t>(0x5004) == 2U);
+        expect(eq(istimulus::count(), 0U));
+    };
+    "action follows simulated clock"_test = [] {
+        simulated_clock clock {};
+        expect(clock.active);
+        stub setup { test_mmio<0x5000> };
+        setup();
+        stimulus sut { inactive_stimulus<0x5000>() };
+        sut.delay(1s)();
+        expect(! istimulus::clock(istimulus::clock_type::steady));
+        *test_addr<uint32_t>(0x5000) = 1U;
+        expect(wait_status(sut, istimulus::status_type::scheduled));
+        istimulus::advance(999ms);
+        expect(sut.status() == istimulus::status_type::scheduled);
+        expect(*test_addr<uint32_t>(0x5004) == 0U);
+        istimulus::advance(1ms);
+        expect(sut.status() == istimulus::status_type::done);
+        expect(*test_addr<uint32_t>(0x5004) == 2U);
+    };
+    "action delayed by ticks"_test = [] {
+        stub setup { test_mmio<0x5000> };
+        setup();
+        stimulus sut { inactive_stimulus<0x5000>() };
+        sut.delay(istimulus::ticks { 1000 })();
+        *test_addr<uint32_t>(0x5000) = 1U;
+        expect(wait_done(sut));
+        expect(*test_addr<uint32_t>(0x5004) == 2U);
+    };
+    "ticks advance with polls of other stimuli"_test = [] {
+        stub setup { test_mmio<0x5000>, test_mmio<0x6000> };
+        setup();
+        stimulus other { active_stimulus<0x6000>() };
+        stimulus sut { inactive_stimulus<0x5000>() };
+        sut.delay(istimulus::ticks { 100 })();
+        const auto before = other.evaluations();
+        *test_addr<uint32_t>(0x5000) = 1U;
+        const auto finish_by = std::chrono::steady_clock::now() + 1s;
+        while(sut.status() != istimulus::status_type::done && std::chrono::steady_clock::now() < finish_by)
+            std::this_thread::yield();
+        expect(sut.status() == istimulus::status_type::done);
+        expect(ge(other.evaluations() - before, 100U));
+        expect(*test_addr<uint32_t>(0x6004) == 0U);
+    };
+    "scheduled stimulus removed with its page"_test = [] {
+        util::scoped_redirector<logcategory::stimulus> ignore {};
+        simulated_clock clock {};
+        stub setup { test_mmio<0x5000> };
+        setup();
+        stimulus kept { inactive_stimulus<0x5000>() };
+        kept.delay(1ms)();
+        auto sut = [] {
+            stub local { test_mmio<0x9000> };
+            local();
+            stimulus result { inactive_stimulus<0x9000>() };
+            result.delay(1ms)();
+            *test_addr<uint32_t>(0x9000) = 1U;
+            expect(wait_status(result, istimulus::status_type::scheduled));
+            return result;
+        }();
+        expect(eq(istimulus::count(), 1U));
+        *test_addr<uint32_t>(0x5000) = 1U;
+        expect(wait_status(kept, istimulus::status_type::scheduled));
+        istimulus::advance(1ms);
+        expect(kept.status() == istimulus::status_type::done);
+        expect(sut.status() == istimulus::status_type::scheduled);
+    };
+    "deactivated stimulus does not act"_test = [] {
+        simulated_clock clock {};
+        stub setup { test_mmio<0x5000> };
+        setup();
+        {
+            stimulus sut { inactive_stimulus<0x5000>() };
+            sut.delay(1ms)();
+            *test_addr<uint32_t>(0x5000) = 1U;
+            expect(wait_status(sut, istimulus::status_type::scheduled));
+        }
+        expect(eq(istimulus::count(), 0U));
+        istimulus::advance(1ms);
+        expect(*test_addr<uint32_t>(0x5004) == 0U);
+    };
+};
+
+suite<"stimulus stats"> stimulus_stats_suite = [] {
+    "stats count polls, evaluations and actions"_test = [] {
+        stub setup { test_mmio<0x5000> };
+        setup();
+        istimulus::reset_stats();
+        stimulus sut { active_stimulus<0x5000>() };
+        test_workflow(sut, *test_addr<uint32_t>(0x5000), 1U);
+        const auto stats = istimulus::stats();
+        expect(ge(sut.evaluations(), 2U));
+        expect(ge(stats.evaluations, sut.evaluations()));
+        expect(gt(stats.polls, 0U));
+        expect(gt(stats.poll_rate(), 0.0));
+        expect(eq(stats.actions, 1U));
+        expect(eq(std::accumulate(stats.latency.begin(), stats.latency.end(), std::uint64_t {}), 1U));
+        expect(stats.percentile(100) > 0ns);
+        istimulus::reset_stats();
+        expect(eq(istimulus::stats().actions, 0U));
+    };
+    "stats count stimuli removed with their pages"_test = [] {
+        util::scoped_redirector<logcategory::stimulus> ignore {};
+        istimulus::reset_stats();
+        auto sut = [] {
+            stub local { test_mmio<0x9000> };
+            local();
+            return active_stimulus<0x9000>();
+        }();
+        expect(eq(istimulus::stats().removed, 1U));
+    };
+    "latency of delayed action includes the delay"_test = [] {
+        stub setup { test_mmio<0x5000> };
+        setup();
+        istimulus::reset_stats();
+        stimulus sut { inactive_stimulus<0x5000>() };
+        sut.delay(5ms)();
+        *test_addr<uint32_t>(0x5000) = 1U;
+        expect(wait_done(sut));
+        expect(istimulus::stats().percentile(50) >= 5ms);
+    };
 };
 
 }
@@ -25,6 +25,7 @@ struct trivial {
 using namespace boost::ut;
 using namespace boost::ut::bdd;
 using namespace boost::ut::literals;
+using stubmmio::test::operator""_p;
 
 constexpr test::native_type fill = 0xA5A5A5A5U;
 const stub::initializer_list shared = { {{0x1000, 8}, generator::one(fill)}, {{0x1008, 8}, generator::one(fill)}};
@@ -106,6 +107,31 @@ suite<"stub"> stub_suite = [] {
         expect(nothrow([&sut](){ sut(); }));
         expect(eq(mmio::arena().allocation_size(), page_size));
     };
+    "apply stubs on adjacent pages"_test = [] {
+        stub sut1 {{address(0x20000), 4U}};
+        stub sut2 {{address(0x21000), 4U}};
+        expect(nothrow([&sut1](){ sut1(); }));
+        expect(nothrow([&sut2](){ sut2(); }));
+        expect(eq(mmio::arena().allocation_size(), 2 * page_size));
+        expect(mmio::arena().contains(pagerange{0x20000_p, 0x22000_p}));
+    };
+    "apply maps contiguous pages with one mmap call"_test = [] {
+        stub sut {
+            {address(0x20000), 4U}, {address(0x20010), 4U}, {address(0x21000), 4U},
+            {address(0x23000), 4U}, {{0x23FFC, 8}}, {address(0x24010), 4U}
+        };
+        const auto mappings = arena::mapping_count();
+        sut();
+        expect(eq(arena::mapping_count() - mappings, 2U));
+        expect(eq(arena::allocation_count(), 2U));
+        expect(eq(mmio::arena().allocation_size(), 4 * page_size));
+    };
+    "apply throws on bytes owned by another stub"_test = [] {
+        stub sut1 {{address(0x20000), 4U}};
+        stub sut2 {{{0x20002, 4}}};
+        sut1();
+        expect(throws<exceptions::conflicting_allocation>([&sut2](){ sut2(); }));
+    };
     "unary concatenation not throws"_test = [] {
         expect(nothrow([]{
             stub sut {{{0x20000, 4}}};
@@ -173,6 +199,69 @@ suite<"stub"> stub_suite = [] {
     };
 };
 
+template<typename T = std::uint32_t>
+auto& at(std::uintptr_t addr) {
+    return *reinterpret_cast<volatile T*>(addr);
 }
 
+suite<"stub shared pages"> stub_shared_pages_suite = [] {
+    "stubs share a page"_test = [] {
+        stub sut1 {{address(0x20000), 1U}};
+        stub sut2 {{address(0x20100), 2U}};
+        sut1();
+        expect(nothrow([&sut2](){ sut2(); }));
+        expect(eq(at(0x20000), 1U));
+        expect(eq(at(0x20100), 2U));
+        expect(eq(arena::allocation_count(), 1U));
+        expect(eq(mmio::arena().allocation_size(), page_size));
+    };
+    "shared page is deallocated with its last owner"_test = [] {
+        {
+            stub sut1 {{address(0x20000), 1U}};
+            sut1();
+            {
+                stub sut2 {{address(0x20100), 2U}};
+                sut2();
+            }
+            expect(mmio::arena().contains(pagerange{0x20000_p, 0x21000_p}));
+            expect(eq(at(0x20000), 1U));
+        }
+        expect(eq(arena::allocation_count(), 0U));
+    };
+    "apply keeps bytes of other stubs in a shared page"_test = [] {
+        stub sut1 {{address(0x20000), 1U}};
+        stub sut2 {{address(0x20100), 2U}};
+        sut1();
+        sut2();
+        at(0x20000) = 3U;
+        at(0x20100) = 4U;
+        sut1();
+        expect(eq(at(0x20000), 1U));
+        expect(eq(at(0x20100), 4U));
+    };
+    "apply maps only pages not shared"_test = [] {
+        stub sut1 {{address(0x21000), 1U}};
+        stub sut2 {{{0x20F00, 0x100}}, {address(0x21004), 2U}};
+        sut1();
+        const auto mappings = arena::mapping_count();
+        sut2();
+        expect(eq(arena::mapping_count() - mappings, 1U));
+        expect(eq(at(0x21000), 1U));
+        expect(eq(at(0x21004), 2U));
+        expect(eq(mmio::arena().allocation_size(), 2 * page_size));
+    };
+    "moved stub keeps its bytes in a shared page"_test = [] {
+        stub sut1 {{address(0x20000), 1U}};
+        stub sut2 {{address(0x20100), 2U}};
+        sut1();
+        sut2();
+        stub moved { std::move(sut1) };
+        stub other {{address(0x20000), 3U}};
+        expect(throws<exceptions::conflicting_allocation>([&other](){ other(); }));
+        moved |= std::move(sut2);
+        expect(mmio::arena().contains(pagerange{0x20000_p, 0x21000_p}));
+        expect(eq(at(0x20100), 2U));
+    };
+};
 
+}
@@ -0,0 +1,250 @@
+/*
+ * Copyright (C) 2025 Eugene Hutorny <eugene@hutorny.in.ua>
+ *
+ * test/svd.cxx - unit tests for CMSIS-SVD importer
+ *
+ * Licensed under MIT License, see full text in LICENSE
+ * or visit page https://opensource.org/license/mit/
+ */
+
+#include <stubmmio/stubmmio.h>
+#include <stubmmio/logger.h>
+#include <stubmmio/svd.h>
+#include <stubmmio/unit.h>
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <unistd.h>
+
+namespace {
+using namespace boost::ut;
+using namespace boost::ut::bdd;
+using namespace stubmmio;
+
+template<typename T = std::uint32_t>
+auto at(std::uintptr_t addr) {
+    return reinterpret_cast<volatile T*>(addr);
+}
+
+constexpr std::string_view sample = R"(<?xml version="1.0" encoding="utf-8"?>
+<!-- sample device -->
+<device schemaVersion="1.3" xmlns:xs="http://www.w3.org/2001/XMLSchema-instance">
+  <name>SAMPLE</name>
+  <cpu><name>CM4</name><revision>r0p1</revision></cpu>
+  <size>32</size>
+  <resetValue>0x00000000</resetValue>
+  <resetMask>0xFFFFFFFF</resetMask>
+  <peripherals>
+    <peripheral>
+      <name>UART0</name>
+      <description>Serial &amp; <![CDATA[<port>]]></description>
+      <baseAddress>0x66000</baseAddress>
+      <addressBlock><offset>0</offset><size>0x100</size><usage>registers</usage></addressBlock>
+      <registers>
+        <register>
+          <name>CTRL</name>
+          <addressOffset>0x0</addressOffset>
+          <resetValue>0x12345678</resetValue>
+          <resetMask>0x0000FFFF</resetMask>
+          <fields>
+            <field><name>EN</name><bitOffset>0</bitOffset><bitWidth>1</bitWidth><access>read-only</access></field>
+          </fields>
+        </register>
+        <register>
+          <name>STATUS</name>
+          <addressOffset>4</addressOffset>
+          <size>16</size>
+          <access>read-only</access>
+          <resetValue>#10x1</resetValue>
+        </register>
+        <register>
+          <name>STATUS_ALT</name>
+          <alternateRegister>STATUS</alternateRegister>
+          <addressOffset>4</addressOffset>
+          <resetValue>0xFFFF</resetValue>
+        </register>
+        <register derivedFrom="CTRL">
+          <name>CTRL2</name>
+          <addressOffset>0x8</addressOffset>
+        </register>
+        <register>
+          <dim>3</dim>
+          <dimIncrement>4</dimIncrement>
+          <dimIndex>A,B,C</dimIndex>
+          <name>DATA%s</name>
+          <addressOffset>0x10</addressOffset>
+          <size>8</size>
+          <resetValue>0x5A</resetValue>
+        </register>
+        <cluster>
+          <dim>2</dim>
+          <dimIncrement>0x10</dimIncrement>
+          <name>CH[%s]</name>
+          <addressOffset>0x40</addressOffset>
+          <resetValue>0xC0</resetValue>
+          <register><name>CFG</name><addressOffset>0</addressOffset></register>
+          <register><name>VAL</name><addressOffset>4</addressOffset><resetValue>1k</resetValue></register>
+        </cluster>
+      </registers>
+    </peripheral>
+    <peripheral derivedFrom="UART0">
+      <name>UART1</name>
+      <baseAddress>0x67000</baseAddress>
+    </peripheral>
+    <peripheral>
+      <name>EMPTY</name>
+      <baseAddress>0x68000</baseAddress>
+    </peripheral>
+  </peripherals>
+</device>
+)";
+
+svd::device parse(std::string_view text) {
+    std::istringstream stream { std::string { text } };
+    return svd::device::parse(stream);
+}
+
+/// temporary directory, removed with its content
+struct scratch {
+    scratch() : path { std::filesystem::temp_directory_path() / ("stubmmio-svd-" + std::to_string(getpid())) } {
+        std::filesystem::create_directories(path);
+    }
+    ~scratch() {
+        std::error_code error {};
+        std::filesystem::remove_all(path, error);
+    }
+    scratch(const scratch&) = delete;
+    scratch(scratch&&) = delete;
+    scratch& operator=(const scratch&) = delete;
+    scratch& operator=(scratch&&) = delete;
+    std::filesystem::path path;
+};
+
+void write_file(const std::filesystem::path& path, std::string_view text) {
+    std::ofstream file { path, std::ios::binary | std::ios::trunc };
+    file << text;
+}
+
+suite<"svd"> svd_suite = [] {
+    "parse builds peripherals and registers"_test = [] {
+        const auto mcu = parse(sample);
+        expect(eq(mcu.name(), std::string_view{"SAMPLE"}));
+        expect(eq(mcu.peripherals().size(), 3U));
+        const auto* uart = mcu.find("UART0");
+        expect(uart != nullptr);
+        if (uart == nullptr) return;
+        expect(eq(uart->address, 0x66000U));
+        expect(eq(mcu.registers(*uart).size(), 10U));
+        const auto* ctrl = mcu.find("UART0", "CTRL");
+        expect(ctrl != nullptr && ctrl->address == 0x66000U && ctrl->reset_value == 0x5678U && ctrl->size == 4U);
+        const auto* status = mcu.find("UART0", "STATUS");
+        expect(status != nullptr && status->reset_value == 0b1001U && status->size == 2U);
+        expect(status != nullptr && status->access == svd::access_type::read_only);
+        expect(mcu.find("UART0", "STATUS_ALT") == nullptr);
+        expect(mcu.find("UART0", "EN") == nullptr);
+        const auto* ctrl2 = mcu.find("UART0", "CTRL2");
+        expect(ctrl2 != nullptr && ctrl2->address == 0x66008U && ctrl2->reset_value == 0x5678U);
+        expect(mcu.find("EMPTY") != nullptr && mcu.registers(*mcu.find("EMPTY")).empty());
+        expect(mcu.find("UART2") == nullptr);
+        expect(! mcu.mapped());
+    };
+    "dim arrays and clusters are expanded"_test = [] {
+        const auto mcu = parse(sample);
+        const auto* datab = mcu.find("UART0", "DATAB");
+        expect(datab != nullptr && datab->address == 0x66014U && datab->size == 1U && datab->reset_value == 0x5AU);
+        const auto* cfg = mcu.find("UART0", "CH[1].CFG");
+        expect(cfg != nullptr && cfg->address == 0x66050U && cfg->reset_value == 0xC0U);
+        const auto* val = mcu.find("UART0", "CH[0].VAL");
+        expect(val != nullptr && val->address == 0x66044U && val->reset_value == 0x400U);
+        const auto* uart = mcu.find("UART0");
+        if (uart == nullptr) return;
+        const auto registers = mcu.registers(*uart);
+        expect(std::ranges::is_sorted(registers, {}, &svd::register_entry::address));
+    };
+    "derived peripheral has registers at its base address"_test = [] {
+        const auto mcu = parse(sample);
+        const auto* ctrl = mcu.find("UART1", "CTRL");
+        expect(ctrl != nullptr && ctrl->address == 0x67000U && ctrl->reset_value == 0x5678U);
+        const auto* val = mcu.find("UART1", "CH[1].VAL");
+        expect(val != nullptr && val->address == 0x67054U);
+    };
+    "on_reset stub applies reset values"_test = [] {
+        const auto mcu = parse(sample);
+        const stub setup = mcu.on_reset({"UART0", "UART1"});
+        expect(eq(setup.element_count(), 20U));
+        setup();
+        expect(eq(*at(0x66000), 0x5678U));
+        expect(eq(*at<std::uint16_t>(0x66004), 0b1001U));
+        expect(eq(*at<std::uint8_t>(0x66018), 0x5AU));
+        expect(eq(*at(0x66054), 0x400U));
+        expect(eq(*at(0x67040), 0xC0U));
+    };
+    "on_reset of unknown peripheral throws"_test = [] {
+        const auto mcu = parse(sample);
+        expect(throws<exceptions::unknown_peripheral>([&] { [[maybe_unused]] auto s = mcu.on_reset({"UART0", "SPI0"}); }));
+    };
+    "malformed svd throws"_test = [] {
+        expect(throws<exceptions::bad_svd_format>([] { parse("<device><name>X</name>"); }));
+        expect(throws<exceptions::bad_svd_format>([] { parse("<device><name>X</size></device>"); }));
+        expect(throws<exceptions::bad_svd_format>([] { parse("<memory/>"); }));
+        expect(throws<exceptions::bad_svd_format>([] {
+            parse("<device><peripherals><peripheral><name>P</name><baseAddress>0xZ</baseAddress></peripheral></peripherals></device>");
+        }));
+        expect(throws<exceptions::bad_svd_format>([] {
+            parse("<device><peripherals><peripheral derivedFrom='Q'><name>P</name><baseAddress>0</baseAddress>"
+                  "</peripheral></peripherals></device>");
+        }));
+    };
+    "saved table maps back"_test = [] {
+        const scratch dir {};
+        const auto parsed = parse(sample);
+        {
+            std::ofstream file { dir.path / "sample.svdt", std::ios::binary };
+            parsed.save(file);
+        }
+        const auto mapped = svd::device::map(dir.path / "sample.svdt");
+        expect(mapped.mapped());
+        expect(eq(mapped.name(), parsed.name()));
+        expect(eq(mapped.registers().size(), parsed.registers().size()));
+        const auto* val = mapped.find("UART1", "CH[0].VAL");
+        expect(val != nullptr && val->address == 0x67044U && val->reset_value == 0x400U);
+        const stub setup = mapped.on_reset({"UART1"});
+        setup();
+        expect(eq(*at(0x67000), 0x5678U));
+    };
+    "corrupted table is rejected"_test = [] {
+        const scratch dir {};
+        write_file(dir.path / "bad.svdt", "SVDT and something else");
+        expect(throws<exceptions::bad_svd_format>([&] { svd::device::map(dir.path / "bad.svdt"); }));
+        std::ostringstream stream {};
+        parse(sample).save(stream);
+        write_file(dir.path / "short.svdt", stream.str().substr(0, stream.str().size() - 10));
+        expect(throws<exceptions::bad_svd_format>([&] { svd::device::map(dir.path / "short.svdt"); }));
+    };
+    "load caches the table until the svd changes"_test = [] {
+        const scratch dir {};
+        const auto source = dir.path / "sample.svd";
+        const auto table = dir.path / "sample.svdt";
+        write_file(source, sample);
+        expect(! svd::device::load(source, table).mapped());
+        expect(std::filesystem::exists(table));
+        expect(svd::device::load(source, table).mapped());
+        std::string changed { sample };
+        changed.replace(changed.find("0x12345678"), 10, "0x00001111");
+        write_file(source, changed);
+        std::filesystem::last_write_time(source, std::filesystem::last_write_time(source) + std::chrono::seconds{1});
+        const auto reloaded = svd::device::load(source, table);
+        expect(! reloaded.mapped());
+        const auto* ctrl = reloaded.find("UART0", "CTRL");
+        expect(ctrl != nullptr && ctrl->reset_value == 0x1111U);
+        expect(svd::device::load(source, table).mapped());
+        write_file(table, "garbage");
+        util::scoped_redirector<logcategory::svd> ignore {};
+        expect(! svd::device::load(source, table).mapped());
+    };
+};
+
+} // namespace
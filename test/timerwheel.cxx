@@ -0,0 +1,75 @@
+/*
+ * Copyright (C) 2025 Eugene Hutorny <eugene@hutorny.in.ua>
+ *
+ * test/timerwheel.cxx - unit tests for timer wheel
+ *
+ * Licensed under MIT License, see full text in LICENSE
+ * or visit page https://opensource.org/license/mit/
+ */
+
+#include <stubmmio/unit.h>
+#include <timerwheel.h>
+#include <cstdint>
+#include <vector>
+
+namespace {
+using namespace stubmmio::detail;
+using namespace boost::ut;
+using namespace boost::ut::bdd;
+using tick_type = timerwheel<unsigned>::tick_type;
+
+auto collect(timerwheel<tick_type>& sut, tick_type to) {
+    std::vector<tick_type> result {};
+    sut.advance(to, [&result](tick_type item) { result.push_back(item); });
+    return result;
+}
+
+suite<"timer wheel"> timerwheel_suite = [] {
+    "items expire in order"_test = [] {
+        timerwheel<tick_type> sut {};
+        for(tick_type expiry : { 70U, 3U, 4096U, 64U, 5000U, 1U })
+            sut.schedule(expiry, expiry);
+        expect(eq(sut.size(), 6U));
+        expect(collect(sut, 2) == std::vector<tick_type>{ 1 });
+        expect(collect(sut, 100) == std::vector<tick_type>{ 3, 64, 70 });
+        expect(eq(sut.now(), 100U));
+        expect(collect(sut, 10000) == std::vector<tick_type>{ 4096, 5000 });
+        expect(sut.empty());
+    };
+    "far items cascade exactly"_test = [] {
+        timerwheel<tick_type> sut { 12345 };
+        constexpr tick_type far = (tick_type { 1 } << 40) + 777;
+        sut.schedule(far, far);
+        sut.schedule(far + 1, far + 1);
+        expect(collect(sut, far - 1).empty());
+        expect(eq(*sut.next_event(), far));
+        expect(collect(sut, far) == std::vector<tick_type>{ far });
+        expect(collect(sut, ~tick_type { 0 }) == std::vector<tick_type>{ far + 1 });
+    };
+    "expired item is due on next advance"_test = [] {
+        timerwheel<tick_type> sut { 100 };
+        sut.schedule(50, 50);
+        expect(eq(*sut.next_event(), 100U));
+        expect(collect(sut, 100) == std::vector<tick_type>{ 50 });
+    };
+    "expired item may schedule another"_test = [] {
+        timerwheel<tick_type> sut {};
+        sut.schedule(10, 10);
+        std::vector<tick_type> fired {};
+        sut.advance(100, [&sut, &fired](tick_type item) {
+            fired.push_back(item);
+            if (item == 10) sut.schedule(item + 20, item + 20);
+        });
+        expect(fired == std::vector<tick_type>{ 10, 30 });
+    };
+    "empty wheel has no events"_test = [] {
+        timerwheel<tick_type> sut {};
+        expect(! sut.next_event());
+        sut.schedule(5, 5);
+        sut.clear();
+        expect(! sut.next_event());
+        expect(sut.empty());
+    };
+};
+
+} // namespace
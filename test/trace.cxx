@@ -0,0 +1,155 @@
+/*
+ * Copyright (C) 2025 Eugene Hutorny <eugene@hutorny.in.ua>
+ *
+ * test/trace.cxx - unit tests for access trace recorder
+ *
+ * Licensed under MIT License, see full text in LICENSE
+ * or visit page https://opensource.org/license/mit/
+ */
+
+#include <stubmmio/stubmmio.h>
+#include <stubmmio/literals.h>
+#include <stubmmio/snapshot.h>
+#include <stubmmio/trace.h>
+#include <stubmmio/unit.h>
+#include <cstdint>
+#include <set>
+#include <sstream>
+#include <thread>
+
+namespace {
+using namespace boost::ut;
+using namespace boost::ut::bdd;
+using namespace stubmmio;
+using namespace stubmmio::literals;
+
+constexpr std::uintptr_t base = 0x48000;
+
+template<typename T = std::uint32_t>
+auto at(std::uintptr_t addr) {
+    return reinterpret_cast<volatile T*>(addr);
+}
+
+struct tracing {
+    explicit tracing(std::size_t capacity = 1024) { trace::start(capacity); }
+    ~tracing() { trace::stop(); }
+    tracing(const tracing&) = delete;
+    tracing(tracing&&) = delete;
+    tracing& operator=(const tracing&) = delete;
+    tracing& operator=(tracing&&) = delete;
+};
+
+suite<"trace"> trace_suite = [] {
+    "accessors record reads and writes"_test = [] {
+        stub setup {{address(base), 0_U32}};
+        setup();
+        tracing on {};
+        trace::write(at(base), 5U);
+        expect(eq(trace::read(at(base)), 5U));
+        trace::write(at<std::uint8_t>(base + 2), std::uint8_t { 0xA5 });
+        const auto records = trace::collect();
+        expect(eq(records.size(), 3U));
+        if (records.size() != 3) return;
+        expect(records[0].kind == trace::kind_type::write);
+        expect(records[1].kind == trace::kind_type::read);
+        expect(eq(records[1].address, base));
+        expect(eq(records[1].width, 4U));
+        expect(eq(records[1].value, 5U));
+        expect(eq(records[2].width, 1U));
+        expect(eq(records[2].value, 0xA5U));
+        expect(records[0].timestamp <= records[1].timestamp && records[1].timestamp <= records[2].timestamp);
+        expect(trace::collect().empty());
+    };
+    "nothing is recorded while stopped"_test = [] {
+        stub setup {{address(base), 0_U32}};
+        setup();
+        trace::start();
+        trace::stop();
+        trace::write(at(base), 1U);
+        expect(! trace::enabled());
+        expect(trace::collect().empty());
+    };
+    "full buffer drops records"_test = [] {
+        stub setup {{address(base), 0_U32}};
+        setup();
+        tracing on { 4 };
+        for(std::uint32_t i = 0; i < 10; ++i) trace::write(at(base), i);
+        const auto records = trace::collect();
+        expect(eq(records.size(), 4U));
+        expect(eq(trace::dropped(), 6U));
+        trace::write(at(base), 10U);
+        expect(eq(trace::collect().size(), 1U));
+    };
+    "threads record into own buffers"_test = [] {
+        stub setup {{address(base), 0_U32}, {address(base + 4), 0_U32}};
+        setup();
+        tracing on {};
+        std::thread first { [] noexcept { for(std::uint32_t i = 0; i < 100; ++i) trace::write(at(base), i); } };
+        std::thread second { [] noexcept { for(std::uint32_t i = 0; i < 100; ++i) trace::write(at(base + 4), i); } };
+        first.join();
+        second.join();
+        const auto records = trace::collect();
+        expect(eq(records.size(), 200U));
+        std::set<std::pair<std::uint16_t, std::uint32_t>> threads {};
+        for(const auto& item : records) threads.emplace(item.thread, item.address);
+        expect(eq(threads.size(), 2U));
+        expect(std::ranges::is_sorted(records, {}, &trace::record::timestamp));
+    };
+    "records survive save and load"_test = [] {
+        const std::vector<trace::record> records {
+            { 100, 0x12345678, 0x40000000, 4, trace::kind_type::write, 0 },
+            { 200, 0xFF, 0x40000004, 1, trace::kind_type::read, 1 },
+        };
+        std::stringstream stream {};
+        trace::save(stream, records);
+        expect(trace::load(stream) == records);
+        expect(eq(trace::format(records[0]), std::string { "             100      0 W 40000000  4 12345678" }));
+    };
+    "malformed trace is rejected"_test = [] {
+        std::stringstream garbage { "not a trace file" };
+        expect(throws<exceptions::bad_trace_format>([&garbage] { trace::load(garbage); }));
+        std::stringstream truncated {};
+        const trace::record item {};
+        trace::save(truncated, { &item, 1 });
+        auto text = truncated.str();
+        text.pop_back();
+        std::stringstream shortened { text };
+        expect(throws<exceptions::bad_trace_format>([&shortened] { trace::load(shortened); }));
+    };
+    "traced page is not allocated"_test = [] {
+        expect(throws<exceptions::page_is_not_allocated>([] { trace::watch(region{ base + 0x10000, 4 }); }));
+    };
+    "accesses to watched page are trapped"_test = [] {
+        stub setup {{address(base), 0_U32}, {address(base + 4), 0_U32}};
+        setup();
+        tracing on {};
+        if (! trace::watch(region{ base, 8 })) return;
+        *at(base) = 7U;
+        const std::uint32_t value = *at(base + 4);
+        trace::unwatch(region{ base, 8 });
+        *at(base) = 8U;
+        const auto records = trace::collect();
+        expect(eq(records.size(), 2U));
+        if (records.size() != 2) return;
+        expect(records[0].kind == trace::kind_type::write);
+        expect(eq(records[0].address, base));
+        expect(eq(records[0].width, 0U));
+        expect(eq(records[0].value & 0xFFFFFFFFU, 7U));
+        expect(records[1].kind == trace::kind_type::read);
+        expect(eq(records[1].address, base + 4));
+        expect(eq(records[1].value & 0xFFFFFFFFU, value));
+    };
+    "accesses after snapshot are trapped"_test = [] {
+        stub setup {{address(base), 0_U32}};
+        setup();
+        tracing on {};
+        if (! trace::watch(region{ base, 4 })) return;
+        const snapshot image {};
+        *at(base) = 7U;
+        trace::unwatch(region{ base, 4 });
+        const auto records = trace::collect();
+        expect(eq(records.size(), 1U));
+    };
+};
+
+} // namespace
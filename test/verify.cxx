@@ -88,5 +88,78 @@ suite<"verify"> verify_suite = [] {
         expect(eq(count, 1U));
         verify::expect = verify::default_expect;
     };
+    "verify reports every mismatch"_test = [] {
+        struct {
+            std::array<test::native_type, 4> values { 1, 2, 3, 4 };
+            std::array<std::uint16_t, 8> buffer { 0xA5A5, 0xA5A5, 0xA5A5, 0xA5A5, 0xA5A5, 0xA5A5, 0xA5A5, 0xA5A5 };
+            test::native_type custom {};
+        } memory {};
+        const verify sut {
+            {&memory.values[0], 1U}, {&memory.values[1], 2U}, {&memory.values[2], 3U}, {&memory.values[3], 4U},
+            {std::span{memory.buffer}, std::uint16_t{0xA5A5}},
+            {{&memory.custom, sizeof(memory.custom)}, [](const void*, const void*) noexcept { return true; }},
+        };
+        expect(sut());
+        expect(sut.mismatches().empty());
+        memory.values[1] = 7;
+        memory.buffer[5] = 0;
+        expect(!sut());
+        const auto report = sut.mismatches();
+        expect(eq(report.size(), 2U));
+        if (report.size() != 2U) return;
+        expect(eq(report[0].address, reinterpret_cast<std::uintptr_t>(&memory.values[1])));
+        expect(eq(report[0].expected.size(), sizeof(test::native_type)));
+        expect(std::to_integer<int>(report[0].expected[0]) == 2);
+        expect(std::to_integer<int>(report[0].actual[0]) == 7);
+        expect(eq(report[1].address, reinterpret_cast<std::uintptr_t>(&memory.buffer[5])));
+        expect(report[1].expected.size() == 2U && report[1].actual.size() == 2U);
+        expect(std::to_integer<int>(report[1].expected[0]) == 0xA5 && std::to_integer<int>(report[1].actual[0]) == 0);
+    };
+    "custom comparator is reported without expected value"_test = [] {
+        test::native_type variable = 0;
+        const verify sut {{{&variable, sizeof(variable)}, [](const void*, const void*) noexcept { return false; }}};
+        const auto report = sut.mismatches();
+        expect(eq(report.size(), 1U));
+        expect(report.front().expected.empty());
+        expect(eq(report.front().actual.size(), sizeof(variable)));
+    };
+    "expect called for each element of a merged range"_test = [] {
+        static unsigned passed {};
+        static unsigned failed {};
+        passed = failed = 0;
+        verify::expect = [](bool success, std::source_location) -> verify::control {
+            ++(success ? passed : failed);
+            return verify::control::run;
+        };
+        std::array<test::native_type, 3> values { 1, 5, 3 };
+        const verify sut {{&values[0], 1U}, {&values[1], 2U}, {&values[2], 3U}};
+        expect(!sut());
+        verify::expect = verify::default_expect;
+        expect(eq(passed, 2U));
+        expect(eq(failed, 1U));
+    };
+    "elements appended after verification are verified"_test = [] {
+        std::array<test::native_type, 3> values { 1, 2, 3 };
+        verify sut {{&values[0], 1U}};
+        expect(sut());
+        sut |= verify {{&values[1], 2U}};
+        sut |= verify {{&values[2], 4U}};
+        expect(!sut());
+        const auto report = sut.mismatches();
+        expect(eq(report.size(), 1U));
+        if (report.empty()) return;
+        expect(eq(report.front().address, reinterpret_cast<std::uintptr_t>(&values[2])));
+    };
+    "moved from verify verifies nothing"_test = [] {
+        std::array<test::native_type, 2> values { 1, 2 };
+        verify src {{&values[0], 7U}};
+        expect(!src());
+        verify sut {{&values[1], 2U}};
+        sut |= std::move(src);
+        expect(eq(sut.element_count(), 2U));
+        expect(!sut());
+        expect(src());
+        expect(src.mismatches().empty());
+    };
 };
 }
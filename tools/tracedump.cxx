@@ -0,0 +1,57 @@
+/*
+ * Copyright (C) 2025 Eugene Hutorny <eugene@hutorny.in.ua>
+ *
+ * tools/tracedump.cxx - decodes stubmmio access trace files
+ *
+ * Licensed under MIT License, see full text in LICENSE
+ * or visit page https://opensource.org/license/mit/
+ */
+
+#include <stubmmio/trace.h>
+#include <exception>
+#include <format>
+#include <fstream>
+#include <iostream>
+#include <string_view>
+
+using namespace stubmmio;
+
+namespace {
+
+int dump(std::istream& stream, std::string_view name) {
+    try {
+        const auto records = trace::load(stream);
+        std::cout << std::format("{:>16} {:>6} {} {:8} {:>2} {}\n", "timestamp", "thread", "K", "address", "W", "value");
+        for(const auto& item : records) std::cout << trace::format(item) << '\n';
+        std::cout << std::format("{}: {} records\n", name, records.size());
+        return 0;
+    } catch(const std::exception& error) {
+        std::cerr << std::format("{}: {}\n", name, error.what());
+        return 1;
+    }
+}
+
+} // namespace
+
+int main(int argc, char *argv[]) {
+    if (argc < 2) {
+        std::cerr << "usage: tracedump <trace-file>... | -\n";
+        return 2;
+    }
+    int result = 0;
+    for(int i = 1; i < argc; ++i) {
+        const std::string_view name { argv[i] };
+        if (name == "-") {
+            result |= dump(std::cin, "stdin");
+            continue;
+        }
+        std::ifstream file { argv[i], std::ios::binary };
+        if (! file) {
+            std::cerr << std::format("{}: cannot open\n", name);
+            result |= 1;
+            continue;
+        }
+        result |= dump(file, name);
+    }
+    return result;
+}